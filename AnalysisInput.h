@@ -0,0 +1,194 @@
+#ifndef ANALYSISINPUT_H
+#define ANALYSISINPUT_H
+
+#include <TFile.h>
+#include <TObject.h>
+#include <TH1.h>
+#include <THnSparse.h>
+#include <TArrayD.h>
+#include <TString.h>
+#include <TSystem.h>
+#include <map>
+#include <string>
+#include <cstdlib>
+#include <iostream>
+#include "BinnedCache.h"
+
+// Input of the macros: AnalysisResults.root, read through its local binned cache (BinnedCache.h) when the cache is up to date.
+// The cache lives in $QA_CACHE_DIR (default ./binned_cache) and is rebuilt automatically when the source file changes.
+// Setting QA_NO_CACHE reads the ROOT file directly. Objects that are not in the cache are read from the ROOT file,
+// which is then opened on first use only.
+// Every object returned by Get is owned by the input and kept for the next Get of the same key. With a memory budget
+// (QA_MEMORY_BUDGET_MB, or SetMemoryBudget), Trim() drops the least recently used objects until the estimated size of
+// the kept ones fits in it; callers call it once they hold no pointer to the objects (PlotArena does it on release).
+class AnalysisInput {
+public:
+    // Path of the cache file of a source file
+    static TString CachePath(const char* fileName) {
+        const char* cacheDir = gSystem->Getenv("QA_CACHE_DIR");
+        TString name = fileName;
+        name.ReplaceAll("/", "_");
+        return TString::Format("%s/%s.qacache", cacheDir && cacheDir[0] ? cacheDir : "binned_cache", name.Data());
+    }
+
+    static bool CacheEnabled() {
+        return !gSystem->Getenv("QA_NO_CACHE");
+    }
+
+    // Builds the cache of the source file if it is missing or stale. Returns true if an up to date cache is available.
+    // RunSelections calls it once before forking, so that the workers do not ingest the same file concurrently.
+    static bool PrepareCache(const char* fileName) {
+        if (!CacheEnabled()) return false;
+        int64_t size = 0, mtime = 0;
+        if (!BinnedCache::SourceStat(fileName, size, mtime)) return false;
+        TString cachePath = CachePath(fileName);
+        BinnedCache::Reader* reader = BinnedCache::Reader::Open(cachePath, size, mtime);
+        if (reader) {
+            delete reader;
+            return true;
+        }
+        std::cout << "Building binned cache " << cachePath << " from " << fileName << "." << std::endl;
+        return BinnedCache::Ingest(fileName, cachePath);
+    }
+
+    // Returns nullptr if neither the cache nor the source file can be opened. With buildCache = false a missing or stale
+    // cache is not rebuilt and the source file is read directly: RunSelections opens the input of each selection this
+    // way, after calling PrepareCache once, so that a failed ingest is not repeated by every worker.
+    static AnalysisInput* Open(const char* fileName, bool buildCache = true) {
+        AnalysisInput* input = new AnalysisInput(fileName);
+        int64_t size = 0, mtime = 0;
+        if (CacheEnabled() && (!buildCache || PrepareCache(fileName)) && BinnedCache::SourceStat(fileName, size, mtime)) {
+            input->fCache = BinnedCache::Reader::Open(CachePath(fileName), size, mtime);
+        }
+        if (!input->fCache && !input->OpenFile()) {
+            delete input;
+            return nullptr;
+        }
+        return input;
+    }
+
+    ~AnalysisInput() {
+        Close();
+    }
+    AnalysisInput(const AnalysisInput&) = delete;
+    AnalysisInput& operator=(const AnalysisInput&) = delete;
+
+    // The returned object belongs to the input, it stays valid until the next Trim() or Close()
+    TObject* Get(const char* key) {
+        auto source = fSources.find(key);
+        if (source != fSources.end()) {
+            source->second.lastUse = ++fUseCount;
+            return source->second.object;
+        }
+        Source loaded;
+        if (fCache && fCache->Has(key)) {
+            loaded.object = fCache->Get(key);
+            loaded.fromCache = true;
+        } else {
+            if (!fFile && !OpenFile()) return nullptr;
+            loaded.object = fFile->Get(key);
+            // Directories and other objects stay with the file
+            if (!dynamic_cast<TH1*>(loaded.object) && !dynamic_cast<THnSparse*>(loaded.object)) return loaded.object;
+            // Histograms are detached from the file, so that evicting them does not leave a dangling entry in it
+            if (TH1* histo = dynamic_cast<TH1*>(loaded.object)) histo->SetDirectory(nullptr);
+        }
+        if (!loaded.object) return nullptr;
+        loaded.bytes = EstimatedBytes(loaded.object);
+        loaded.lastUse = ++fUseCount;
+        fBytes += loaded.bytes;
+        fSources[key] = loaded;
+        return loaded.object;
+    }
+
+    // Memory budget of the kept source objects in MB, 0 for no limit
+    void SetMemoryBudget(double megabytes) { fBudget = megabytes * 1024 * 1024; }
+    double GetMemoryBudget() const { return fBudget / (1024 * 1024); }
+
+    // Drops the least recently used source objects until the kept ones fit in the memory budget
+    void Trim() {
+        while (fBudget > 0 && fBytes > fBudget && !fSources.empty()) {
+            auto oldest = fSources.begin();
+            for (auto it = fSources.begin(); it != fSources.end(); ++it) {
+                if (it->second.lastUse < oldest->second.lastUse) oldest = it;
+            }
+            Evict(oldest);
+        }
+    }
+
+    size_t KeptObjects() const { return fSources.size(); }
+    double KeptMegabytes() const { return fBytes / (1024 * 1024); }
+
+    const char* GetName() const { return fFileName.Data(); }
+    bool IsCached() const { return fCache != nullptr; }
+
+    // In memory size of a histogram or sparse: contents and squared errors, plus the coordinates and hash entry of each
+    // filled bin of a sparse
+    static double EstimatedBytes(const TObject* obj) {
+        if (const THnSparse* sparse = dynamic_cast<const THnSparse*>(obj)) {
+            double bytesPerBin = 8 + (sparse->GetCalculateErrors() ? 8 : 0) + 24 + sparse->GetNdimensions();
+            return sparse->GetNbins() * bytesPerBin;
+        }
+        if (const TH1* histo = dynamic_cast<const TH1*>(obj)) {
+            double bytesPerCell = (dynamic_cast<const TArrayD*>(histo) ? 8 : 4) + (histo->GetSumw2N() ? 8 : 0);
+            return histo->GetNcells() * bytesPerCell;
+        }
+        return 0;
+    }
+
+    void Close() {
+        while (!fSources.empty()) {
+            Evict(fSources.begin());
+        }
+        delete fCache;
+        fCache = nullptr;
+        if (fFile) {
+            fFile->Close();
+            delete fFile;
+            fFile = nullptr;
+        }
+    }
+
+private:
+    struct Source {
+        TObject* object = nullptr;
+        bool fromCache = false;
+        double bytes = 0;
+        unsigned long lastUse = 0;
+    };
+
+    explicit AnalysisInput(const char* fileName) : fFileName(fileName) {
+        const char* budget = gSystem->Getenv("QA_MEMORY_BUDGET_MB");
+        if (budget) SetMemoryBudget(std::atof(budget));
+    }
+
+    void Evict(std::map<std::string, Source>::iterator source) {
+        if (source->second.fromCache) {
+            fCache->Release(source->first.c_str());
+        } else {
+            delete source->second.object;
+        }
+        fBytes -= source->second.bytes;
+        fSources.erase(source);
+    }
+
+    bool OpenFile() {
+        fFile = TFile::Open(fFileName);
+        if (!fFile || fFile->IsZombie()) {
+            std::cerr << "Error opening file " << fFileName << "." << std::endl;
+            delete fFile;
+            fFile = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    TString fFileName;
+    BinnedCache::Reader* fCache = nullptr;
+    TFile* fFile = nullptr;
+    std::map<std::string, Source> fSources;
+    double fBytes = 0;
+    double fBudget = 0;
+    unsigned long fUseCount = 0;
+};
+
+#endif
@@ -0,0 +1,599 @@
+#ifndef BINNEDCACHE_H
+#define BINNEDCACHE_H
+
+#include <TFile.h>
+#include <TKey.h>
+#include <TClass.h>
+#include <TDirectory.h>
+#include <TH1.h>
+#include <THnSparse.h>
+#include <TAxis.h>
+#include <TString.h>
+#include <TSystem.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// Local columnar copy of the binned objects read by the macros (THnSparse, TH1, TH2, TH3), so that a re-run does not
+// read and decompress AnalysisResults.root from dcache again.
+// Layout of a cache file: header | column data (8-byte aligned) | index.
+// The header records the size and modification time of the source file: the cache is stale as soon as they change.
+// The index stores, for each object, its key, class, axes (edges, titles, labels), statistics and the offsets of its columns:
+// the filled bins of a THnSparse as one int32 coordinate column per axis, the non-empty cells of a histogram as one int64
+// global bin column, plus the contents and the squared errors as double columns.
+// Readers map the file and build an object only the first time it is asked for.
+namespace BinnedCache {
+
+const char kMagic[8] = {'Q', 'A', 'B', 'I', 'N', 'C', 'C', 'H'};
+const uint32_t kVersion = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t nObjects;
+    int64_t sourceSize;
+    int64_t sourceMtime;
+    uint64_t indexOffset;
+    uint64_t indexSize;
+};
+
+struct AxisInfo {
+    std::string name;
+    std::string title;
+    int nBins = 0;
+    bool variable = false;
+    std::vector<double> edges;        // nBins + 1 edges
+    std::vector<std::string> labels;  // empty if the axis has no bin labels
+};
+
+struct ObjectInfo {
+    std::string key;
+    std::string className;
+    std::string title;
+    bool sparse = false;
+    bool hasSumw2 = false;
+    double entries = 0;
+    std::vector<double> stats;          // TH1::GetStats, histograms only
+    std::vector<AxisInfo> axes;
+    uint64_t nCells = 0;
+    std::vector<uint64_t> binColumns;   // sparse: one int32 coordinate column per axis, histogram: one int64 global bin column
+    uint64_t contentColumn = 0;
+    uint64_t err2Column = 0;            // 0 if the object has no squared errors
+};
+
+// Size and modification time of the source file, false if it cannot be accessed
+inline bool SourceStat(const char* fileName, int64_t& size, int64_t& mtime) {
+    FileStat_t stat;
+    if (gSystem->GetPathInfo(fileName, stat) != 0) return false;
+    size = stat.fSize;
+    mtime = stat.fMtime;
+    return true;
+}
+
+class IndexBuffer {
+public:
+    template <class T>
+    void Put(const T& value) {
+        fData.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void PutString(const std::string& s) {
+        Put<uint32_t>(s.size());
+        fData.append(s);
+    }
+    template <class T>
+    void PutVector(const std::vector<T>& v) {
+        Put<uint64_t>(v.size());
+        if (!v.empty()) fData.append(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+    }
+    const std::string& Data() const { return fData; }
+
+private:
+    std::string fData;
+};
+
+class IndexCursor {
+public:
+    IndexCursor(const char* begin, const char* end) : fPos(begin), fEnd(end) {}
+    template <class T>
+    T Get() {
+        T value{};
+        if (!Check(sizeof(T))) return value;
+        std::memcpy(&value, fPos, sizeof(T));
+        fPos += sizeof(T);
+        return value;
+    }
+    std::string GetString() {
+        uint32_t n = Get<uint32_t>();
+        if (!Check(n)) return "";
+        std::string s(fPos, n);
+        fPos += n;
+        return s;
+    }
+    template <class T>
+    std::vector<T> GetVector() {
+        uint64_t n = Get<uint64_t>();
+        std::vector<T> v;
+        if (!Check(n * sizeof(T))) return v;
+        v.resize(n);
+        if (n) std::memcpy(v.data(), fPos, n * sizeof(T));
+        fPos += n * sizeof(T);
+        return v;
+    }
+    bool Ok() const { return fOk; }
+
+private:
+    bool Check(uint64_t n) {
+        if (!fOk || uint64_t(fEnd - fPos) < n) fOk = false;
+        return fOk;
+    }
+    const char* fPos;
+    const char* fEnd;
+    bool fOk = true;
+};
+
+inline AxisInfo DescribeAxis(const TAxis* axis) {
+    AxisInfo info;
+    info.name = axis->GetName();
+    info.title = axis->GetTitle();
+    info.nBins = axis->GetNbins();
+    info.variable = axis->GetXbins()->GetSize() > 0;
+    for (int b = 1; b <= info.nBins; ++b) {
+        info.edges.push_back(axis->GetBinLowEdge(b));
+    }
+    info.edges.push_back(axis->GetBinUpEdge(info.nBins));
+    if (axis->GetLabels()) {
+        for (int b = 1; b <= info.nBins; ++b) {
+            info.labels.push_back(axis->GetBinLabel(b));
+        }
+    }
+    return info;
+}
+
+inline void RestoreAxis(TAxis* axis, const AxisInfo& info) {
+    axis->SetName(info.name.c_str());
+    axis->SetTitle(info.title.c_str());
+    for (size_t b = 0; b < info.labels.size(); ++b) {
+        if (!info.labels[b].empty()) axis->SetBinLabel(b + 1, info.labels[b].c_str());
+    }
+}
+
+// Writes a cache file: columns are streamed as the objects are added, the index and the header at the end
+class Writer {
+public:
+    explicit Writer(const char* path) : fOut(path, std::ios::binary | std::ios::trunc) {
+        Header header{};
+        fOut.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    bool IsOpen() const { return fOut.good(); }
+
+    bool Add(const std::string& key, TObject* obj) {
+        if (THnSparse* sparse = dynamic_cast<THnSparse*>(obj)) {
+            AddSparse(key, sparse);
+            return true;
+        }
+        if (TH1* histo = dynamic_cast<TH1*>(obj)) {
+            AddHistogram(key, histo);
+            return true;
+        }
+        return false;
+    }
+
+    bool Finish(int64_t sourceSize, int64_t sourceMtime) {
+        IndexBuffer index;
+        for (const ObjectInfo& info : fObjects) {
+            index.PutString(info.key);
+            index.PutString(info.className);
+            index.PutString(info.title);
+            index.Put<uint8_t>(info.sparse);
+            index.Put<uint8_t>(info.hasSumw2);
+            index.Put<double>(info.entries);
+            index.PutVector(info.stats);
+            index.Put<uint32_t>(info.axes.size());
+            for (const AxisInfo& axis : info.axes) {
+                index.PutString(axis.name);
+                index.PutString(axis.title);
+                index.Put<int32_t>(axis.nBins);
+                index.Put<uint8_t>(axis.variable);
+                index.PutVector(axis.edges);
+                index.Put<uint32_t>(axis.labels.size());
+                for (const std::string& label : axis.labels) {
+                    index.PutString(label);
+                }
+            }
+            index.Put<uint64_t>(info.nCells);
+            index.PutVector(info.binColumns);
+            index.Put<uint64_t>(info.contentColumn);
+            index.Put<uint64_t>(info.err2Column);
+        }
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.nObjects = fObjects.size();
+        header.sourceSize = sourceSize;
+        header.sourceMtime = sourceMtime;
+        header.indexOffset = WriteColumn(index.Data().data(), index.Data().size());
+        header.indexSize = index.Data().size();
+        fOut.seekp(0);
+        fOut.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fOut.close();
+        return !fOut.fail();
+    }
+
+private:
+    uint64_t WriteColumn(const void* data, size_t bytes) {
+        static const char padding[8] = {0};
+        uint64_t offset = fOut.tellp();
+        if (offset % 8) {
+            fOut.write(padding, 8 - offset % 8);
+            offset += 8 - offset % 8;
+        }
+        if (bytes) fOut.write(static_cast<const char*>(data), bytes);
+        return offset;
+    }
+
+    void AddSparse(const std::string& key, THnSparse* h) {
+        ObjectInfo info;
+        info.key = key;
+        info.className = h->ClassName();
+        info.title = h->GetTitle();
+        info.sparse = true;
+        info.hasSumw2 = h->GetCalculateErrors();
+        info.entries = h->GetEntries();
+        int nDims = h->GetNdimensions();
+        for (int d = 0; d < nDims; ++d) {
+            info.axes.push_back(DescribeAxis(h->GetAxis(d)));
+        }
+        Long64_t nFilled = h->GetNbins();
+        std::vector<std::vector<int32_t>> coords(nDims, std::vector<int32_t>(nFilled));
+        std::vector<double> contents(nFilled), errors2(nFilled);
+        std::vector<Int_t> coord(nDims);
+        for (Long64_t idx = 0; idx < nFilled; ++idx) {
+            contents[idx] = h->GetBinContent(idx, coord.data());
+            errors2[idx] = h->GetBinError2(idx);
+            for (int d = 0; d < nDims; ++d) {
+                coords[d][idx] = coord[d];
+            }
+        }
+        info.nCells = nFilled;
+        for (int d = 0; d < nDims; ++d) {
+            info.binColumns.push_back(WriteColumn(coords[d].data(), nFilled * sizeof(int32_t)));
+        }
+        info.contentColumn = WriteColumn(contents.data(), nFilled * sizeof(double));
+        info.err2Column = WriteColumn(errors2.data(), nFilled * sizeof(double));
+        fObjects.push_back(info);
+    }
+
+    void AddHistogram(const std::string& key, TH1* h) {
+        ObjectInfo info;
+        info.key = key;
+        info.className = h->ClassName();
+        info.title = h->GetTitle();
+        info.hasSumw2 = h->GetSumw2N() > 0;
+        info.entries = h->GetEntries();
+        info.stats.assign(TH1::kNstat, 0.);
+        h->GetStats(info.stats.data());
+        info.axes.push_back(DescribeAxis(h->GetXaxis()));
+        if (h->GetDimension() > 1) info.axes.push_back(DescribeAxis(h->GetYaxis()));
+        if (h->GetDimension() > 2) info.axes.push_back(DescribeAxis(h->GetZaxis()));
+        // Only the non-empty cells are kept, the Lund planes and the QA histograms are mostly empty
+        std::vector<int64_t> bins;
+        std::vector<double> contents, errors2;
+        const double* sumw2 = info.hasSumw2 ? h->GetSumw2()->GetArray() : nullptr;
+        for (int bin = 0; bin < h->GetNcells(); ++bin) {
+            double content = h->GetBinContent(bin);
+            double error2 = sumw2 ? sumw2[bin] : 0;
+            if (content == 0 && error2 == 0) continue;
+            bins.push_back(bin);
+            contents.push_back(content);
+            errors2.push_back(error2);
+        }
+        info.nCells = bins.size();
+        info.binColumns.push_back(WriteColumn(bins.data(), bins.size() * sizeof(int64_t)));
+        info.contentColumn = WriteColumn(contents.data(), contents.size() * sizeof(double));
+        info.err2Column = sumw2 ? WriteColumn(errors2.data(), errors2.size() * sizeof(double)) : 0;
+        fObjects.push_back(info);
+    }
+
+    std::ofstream fOut;
+    std::vector<ObjectInfo> fObjects;
+};
+
+// Read-only view of a cache file, objects are built from the mapped columns on the first Get and owned by the reader
+class Reader {
+public:
+    // Returns nullptr if the cache file is missing, corrupted or does not match the source size and modification time
+    static Reader* Open(const char* path, int64_t sourceSize, int64_t sourceMtime) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+            close(fd);
+            return nullptr;
+        }
+        size_t size = st.st_size;
+        void* base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) return nullptr;
+        Reader* reader = new Reader(static_cast<const char*>(base), size);
+        if (!reader->ReadIndex(sourceSize, sourceMtime)) {
+            delete reader;
+            return nullptr;
+        }
+        return reader;
+    }
+
+    ~Reader() {
+        for (auto& built : fBuilt) {
+            delete built.second;
+        }
+        munmap(const_cast<char*>(fBase), fSize);
+    }
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    bool Has(const char* key) const { return fIndex.count(key) > 0; }
+    size_t Size() const { return fIndex.size(); }
+
+    TObject* Get(const char* key) {
+        auto built = fBuilt.find(key);
+        if (built != fBuilt.end()) return built->second;
+        auto it = fIndex.find(key);
+        if (it == fIndex.end()) return nullptr;
+        TObject* obj = it->second.sparse ? BuildSparse(it->second) : BuildHistogram(it->second);
+        fBuilt[key] = obj;
+        return obj;
+    }
+
+    // Deletes the object built for key, the next Get builds it again from the mapped columns
+    void Release(const char* key) {
+        auto built = fBuilt.find(key);
+        if (built == fBuilt.end()) return;
+        delete built->second;
+        fBuilt.erase(built);
+    }
+
+private:
+    Reader(const char* base, size_t size) : fBase(base), fSize(size) {}
+
+    bool ReadIndex(int64_t sourceSize, int64_t sourceMtime) {
+        Header header;
+        std::memcpy(&header, fBase, sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) return false;
+        if (header.sourceSize != sourceSize || header.sourceMtime != sourceMtime) return false;
+        if (header.indexOffset + header.indexSize > fSize) return false;
+        IndexCursor cursor(fBase + header.indexOffset, fBase + header.indexOffset + header.indexSize);
+        for (uint32_t i = 0; i < header.nObjects && cursor.Ok(); ++i) {
+            ObjectInfo info;
+            info.key = cursor.GetString();
+            info.className = cursor.GetString();
+            info.title = cursor.GetString();
+            info.sparse = cursor.Get<uint8_t>();
+            info.hasSumw2 = cursor.Get<uint8_t>();
+            info.entries = cursor.Get<double>();
+            info.stats = cursor.GetVector<double>();
+            uint32_t nAxes = cursor.Get<uint32_t>();
+            for (uint32_t a = 0; a < nAxes && cursor.Ok(); ++a) {
+                AxisInfo axis;
+                axis.name = cursor.GetString();
+                axis.title = cursor.GetString();
+                axis.nBins = cursor.Get<int32_t>();
+                axis.variable = cursor.Get<uint8_t>();
+                axis.edges = cursor.GetVector<double>();
+                uint32_t nLabels = cursor.Get<uint32_t>();
+                for (uint32_t l = 0; l < nLabels && cursor.Ok(); ++l) {
+                    axis.labels.push_back(cursor.GetString());
+                }
+                info.axes.push_back(axis);
+            }
+            info.nCells = cursor.Get<uint64_t>();
+            info.binColumns = cursor.GetVector<uint64_t>();
+            info.contentColumn = cursor.Get<uint64_t>();
+            info.err2Column = cursor.Get<uint64_t>();
+            if (!ColumnsInFile(info)) return false;
+            fIndex[info.key] = info;
+        }
+        return cursor.Ok();
+    }
+
+    // A truncated cache file is treated as stale
+    bool ColumnsInFile(const ObjectInfo& info) const {
+        size_t binSize = info.sparse ? sizeof(int32_t) : sizeof(int64_t);
+        uint64_t columns[] = {info.contentColumn, info.err2Column};
+        for (uint64_t offset : info.binColumns) {
+            if (offset + info.nCells * binSize > fSize) return false;
+        }
+        for (uint64_t offset : columns) {
+            if (offset + info.nCells * sizeof(double) > fSize) return false;
+        }
+        return info.sparse ? info.binColumns.size() == info.axes.size() : info.binColumns.size() == 1;
+    }
+
+    template <class T>
+    const T* Column(uint64_t offset) const {
+        return reinterpret_cast<const T*>(fBase + offset);
+    }
+
+    TObject* BuildSparse(const ObjectInfo& info) const {
+        int nDims = info.axes.size();
+        std::vector<Int_t> nBins(nDims);
+        std::vector<Double_t> xMin(nDims), xMax(nDims);
+        for (int d = 0; d < nDims; ++d) {
+            nBins[d] = info.axes[d].nBins;
+            xMin[d] = info.axes[d].edges.front();
+            xMax[d] = info.axes[d].edges.back();
+        }
+        const char* name = gSystem->BaseName(info.key.c_str());
+        // ClassName() of a sparse is the one of its template instance, e.g. THnSparseT<TArrayF> for THnSparseF
+        const char* title = info.title.c_str();
+        THnSparse* h = nullptr;
+        if (info.className == THnSparseD::Class()->GetName()) {
+            h = new THnSparseD(name, title, nDims, nBins.data(), xMin.data(), xMax.data());
+        } else if (info.className == THnSparseF::Class()->GetName()) {
+            h = new THnSparseF(name, title, nDims, nBins.data(), xMin.data(), xMax.data());
+        } else if (info.className == THnSparseL::Class()->GetName()) {
+            h = new THnSparseL(name, title, nDims, nBins.data(), xMin.data(), xMax.data());
+        } else if (info.className == THnSparseI::Class()->GetName()) {
+            h = new THnSparseI(name, title, nDims, nBins.data(), xMin.data(), xMax.data());
+        } else if (info.className == THnSparseS::Class()->GetName()) {
+            h = new THnSparseS(name, title, nDims, nBins.data(), xMin.data(), xMax.data());
+        } else if (info.className == THnSparseC::Class()->GetName()) {
+            h = new THnSparseC(name, title, nDims, nBins.data(), xMin.data(), xMax.data());
+        } else {
+            std::cerr << "Cannot build " << info.className << " " << info.key << " from the binned cache." << std::endl;
+            return nullptr;
+        }
+        for (int d = 0; d < nDims; ++d) {
+            if (info.axes[d].variable) h->GetAxis(d)->Set(nBins[d], info.axes[d].edges.data());
+            RestoreAxis(h->GetAxis(d), info.axes[d]);
+        }
+        if (info.hasSumw2) h->Sumw2();
+        std::vector<const int32_t*> coordColumns;
+        for (uint64_t offset : info.binColumns) {
+            coordColumns.push_back(Column<int32_t>(offset));
+        }
+        const double* contents = Column<double>(info.contentColumn);
+        const double* errors2 = info.err2Column ? Column<double>(info.err2Column) : nullptr;
+        std::vector<Int_t> coord(nDims);
+        for (uint64_t i = 0; i < info.nCells; ++i) {
+            for (int d = 0; d < nDims; ++d) {
+                coord[d] = coordColumns[d][i];
+            }
+            Long64_t bin = h->GetBin(coord.data());
+            h->SetBinContent(bin, contents[i]);
+            if (info.hasSumw2 && errors2) h->SetBinError2(bin, errors2[i]);
+        }
+        h->SetEntries(info.entries);
+        return h;
+    }
+
+    TObject* BuildHistogram(const ObjectInfo& info) const {
+        TClass* cl = TClass::GetClass(info.className.c_str());
+        if (!cl || !cl->InheritsFrom(TH1::Class())) {
+            std::cerr << "Cannot build " << info.className << " " << info.key << " from the binned cache." << std::endl;
+            return nullptr;
+        }
+        bool addDirectory = TH1::AddDirectoryStatus();
+        TH1::AddDirectory(kFALSE);
+        TH1* h = static_cast<TH1*>(cl->New());
+        TH1::AddDirectory(addDirectory);
+        h->SetName(gSystem->BaseName(info.key.c_str()));
+        h->SetTitle(info.title.c_str());
+        const std::vector<AxisInfo>& axes = info.axes;
+        bool variable = false;
+        for (const AxisInfo& axis : axes) {
+            variable |= axis.variable;
+        }
+        if (axes.size() == 1) {
+            if (variable) h->SetBins(axes[0].nBins, axes[0].edges.data());
+            else h->SetBins(axes[0].nBins, axes[0].edges.front(), axes[0].edges.back());
+        } else if (axes.size() == 2) {
+            if (variable) h->SetBins(axes[0].nBins, axes[0].edges.data(), axes[1].nBins, axes[1].edges.data());
+            else h->SetBins(axes[0].nBins, axes[0].edges.front(), axes[0].edges.back(), axes[1].nBins, axes[1].edges.front(), axes[1].edges.back());
+        } else if (axes.size() == 3) {
+            if (variable) h->SetBins(axes[0].nBins, axes[0].edges.data(), axes[1].nBins, axes[1].edges.data(), axes[2].nBins, axes[2].edges.data());
+            else h->SetBins(axes[0].nBins, axes[0].edges.front(), axes[0].edges.back(), axes[1].nBins, axes[1].edges.front(), axes[1].edges.back(), axes[2].nBins, axes[2].edges.front(), axes[2].edges.back());
+        }
+        TAxis* histAxes[] = {h->GetXaxis(), h->GetYaxis(), h->GetZaxis()};
+        for (size_t a = 0; a < axes.size(); ++a) {
+            RestoreAxis(histAxes[a], axes[a]);
+        }
+        if (info.hasSumw2) h->Sumw2();
+        const int64_t* bins = Column<int64_t>(info.binColumns[0]);
+        const double* contents = Column<double>(info.contentColumn);
+        const double* errors2 = info.err2Column ? Column<double>(info.err2Column) : nullptr;
+        double* sumw2 = info.hasSumw2 ? h->GetSumw2()->GetArray() : nullptr;
+        for (uint64_t i = 0; i < info.nCells; ++i) {
+            h->SetBinContent(bins[i], contents[i]);
+            if (sumw2 && errors2) sumw2[bins[i]] = errors2[i];
+        }
+        std::vector<double> stats = info.stats;
+        h->PutStats(stats.data());
+        h->SetEntries(info.entries);
+        return h;
+    }
+
+    const char* fBase;
+    size_t fSize;
+    std::map<std::string, ObjectInfo> fIndex;
+    std::map<std::string, TObject*> fBuilt;
+};
+
+// Top-level directories of AnalysisResults.root read by the macros
+inline const std::vector<std::string>& DefaultPrefixes() {
+    static const std::vector<std::string> prefixes = {"track-jet-qa_", "jet-finder-charged-qa", "jet-lund-reclustering"};
+    return prefixes;
+}
+
+inline void CollectObjects(TDirectory* dir, const std::string& path, Writer& writer, const std::vector<std::string>& prefixes) {
+    std::set<std::string> seen;
+    TIter next(dir->GetListOfKeys());
+    while (TKey* key = static_cast<TKey*>(next())) {
+        // Keys are sorted by decreasing cycle, only the latest cycle of each name is kept
+        if (!seen.insert(key->GetName()).second) continue;
+        std::string name = path.empty() ? key->GetName() : path + "/" + key->GetName();
+        if (path.empty()) {
+            bool selected = false;
+            for (const std::string& prefix : prefixes) {
+                selected |= name.compare(0, prefix.size(), prefix) == 0;
+            }
+            if (!selected) continue;
+        }
+        TClass* cl = TClass::GetClass(key->GetClassName());
+        if (!cl) continue;
+        if (cl->InheritsFrom(TDirectory::Class())) {
+            TDirectory* subDir = dir->GetDirectory(key->GetName());
+            if (subDir) CollectObjects(subDir, name, writer, prefixes);
+        } else if (cl->InheritsFrom(TH1::Class()) || cl->InheritsFrom(THnSparse::Class())) {
+            TObject* obj = key->ReadObj();
+            writer.Add(name, obj);
+            delete obj;
+        }
+    }
+}
+
+// Converts the selected objects of the source file into the cache file. The cache is written next to its final path and
+// renamed at the end, so a reader never sees a partially written cache.
+inline bool Ingest(const char* sourceFile, const char* cacheFile, const std::vector<std::string>& prefixes = DefaultPrefixes()) {
+    int64_t sourceSize = 0, sourceMtime = 0;
+    if (!SourceStat(sourceFile, sourceSize, sourceMtime)) {
+        std::cerr << "Cannot access " << sourceFile << "." << std::endl;
+        return false;
+    }
+    TFile* source = TFile::Open(sourceFile);
+    if (!source || source->IsZombie()) {
+        std::cerr << "Error opening file " << sourceFile << "." << std::endl;
+        delete source;
+        return false;
+    }
+    gSystem->mkdir(gSystem->GetDirName(cacheFile), kTRUE);
+    TString tmpFile = TString::Format("%s.tmp%d", cacheFile, gSystem->GetPid());
+    Writer writer(tmpFile);
+    bool written = writer.IsOpen();
+    if (written) {
+        CollectObjects(source, "", writer, prefixes);
+        written = writer.Finish(sourceSize, sourceMtime);
+    }
+    source->Close();
+    delete source;
+    if (!written || std::rename(tmpFile.Data(), cacheFile) != 0) {
+        std::cerr << "Error writing binned cache " << cacheFile << "." << std::endl;
+        gSystem->Unlink(tmpFile);
+        return false;
+    }
+    return true;
+}
+
+} // namespace BinnedCache
+
+#endif
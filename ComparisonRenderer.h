@@ -0,0 +1,225 @@
+#ifndef COMPARISONRENDERER_H
+#define COMPARISONRENDERER_H
+
+#include <Rtypes.h>
+#include <TROOT.h>
+#include <TSystem.h>
+#include <TCanvas.h>
+#include <TVirtualPad.h>
+#include <TH1.h>
+#include <TStyle.h>
+#include <TLatex.h>
+#include <TLegend.h>
+#include <TPaveStats.h>
+#include <TString.h>
+#include <ROOT/TProcessExecutor.hxx>
+#include <ROOT/TSeq.hxx>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+
+// How a panel of a comparison canvas is drawn
+enum class PanelStyle {
+    kMap,       // one TH2, COLZ with log z, as Plot2DHistogram in QAplots.C
+    kSpectrum,  // one TH1, as Plot1DHistogram in QAplots.C
+    kOverlay    // one TH1 per selection on the same axes, as PlotProjectionsTogether in QAplay.C
+};
+
+struct ComparisonPanel {
+    PanelStyle style = PanelStyle::kOverlay;
+    std::vector<TH1*> histos;       // kMap / kSpectrum: a single histogram, kOverlay: one per entry of labels / colors
+    std::vector<TString> labels;    // legend entries of the overlay
+    std::vector<Color_t> colors;
+    TString header;                 // optional line drawn above the frame, e.g. the selection of a kMap panel
+    Color_t headerColor = kBlack;
+    bool logY = false;
+};
+
+// One output image: nx x ny panels drawn on a single canvas
+struct ComparisonJob {
+    TString fileName;
+    int nx = 1;
+    int ny = 1;
+    int width = 1000;
+    int height = 1000;
+    std::vector<ComparisonPanel> panels;
+};
+
+// Draws comparison canvases directly from histograms, one canvas pass per output image.
+// The histograms are handed over in memory (read from the analysis output, from the projection files of QAplay.C or
+// built by the caller) and owned by the renderer. With parallel = true the jobs are spread over forked worker processes:
+// the workers inherit the jobs and histograms of the parent, and each one draws and saves its own canvases.
+class ComparisonRenderer {
+public:
+    ComparisonRenderer() = default;
+    ~ComparisonRenderer() {
+        for (TH1* histo : fOwned) {
+            delete histo;
+        }
+    }
+    ComparisonRenderer(const ComparisonRenderer&) = delete;
+    ComparisonRenderer& operator=(const ComparisonRenderer&) = delete;
+
+    // Takes ownership of the histogram and detaches it from its file, returns it for convenience
+    TH1* Adopt(TH1* histo) {
+        if (!histo) return nullptr;
+        histo->SetDirectory(nullptr);
+        fOwned.push_back(histo);
+        return histo;
+    }
+
+    ComparisonJob& AddJob(const char* fileName, int nx, int ny, int width, int height) {
+        fJobs.emplace_back();
+        ComparisonJob& job = fJobs.back();
+        job.fileName = fileName;
+        job.nx = nx;
+        job.ny = ny;
+        job.width = width;
+        job.height = height;
+        return job;
+    }
+
+    size_t Size() const { return fJobs.size(); }
+
+    // Renders all the jobs and returns the number of images saved
+    int Render(bool parallel = true) {
+        if (!parallel || fJobs.size() < 2) {
+            int saved = 0;
+            for (const ComparisonJob& job : fJobs) {
+                saved += RenderJob(job);
+            }
+            return saved;
+        }
+        // Workers only save images, and must not share the graphics connection of the parent
+        bool wasBatch = gROOT->IsBatch();
+        gROOT->SetBatch(kTRUE);
+        SysInfo_t sysInfo;
+        gSystem->GetSysInfo(&sysInfo);
+        unsigned nWorkers = std::max(1, std::min<int>(fJobs.size(), sysInfo.fCpus));
+        ROOT::TProcessExecutor workers(nWorkers);
+        auto renderJob = [this](int i) { return RenderJob(fJobs[i]); };
+        std::vector<int> saved = workers.Map(renderJob, ROOT::TSeqI(fJobs.size()));
+        gROOT->SetBatch(wasBatch);
+        return std::accumulate(saved.begin(), saved.end(), 0);
+    }
+
+private:
+    static int RenderJob(const ComparisonJob& job) {
+        TCanvas* canvas = new TCanvas("canvas", "Comparison", job.width, job.height);
+        canvas->Divide(job.nx, job.ny);
+        // Line widths and marker sizes of the single plots are scaled to the size of each pad
+        double padHeight = double(job.height) / job.ny;
+        bool drawn = false;
+        for (size_t i = 0; i < job.panels.size() && int(i) < job.nx * job.ny; ++i) {
+            canvas->cd(i + 1);
+            drawn |= DrawPanel(job.panels[i], padHeight);
+        }
+        if (drawn) {
+            canvas->SaveAs(job.fileName);
+        } else {
+            std::cerr << "Nothing to draw for " << job.fileName << "." << std::endl;
+        }
+        delete canvas;
+        return drawn ? 1 : 0;
+    }
+
+    static bool DrawPanel(const ComparisonPanel& panel, double padHeight) {
+        if (panel.histos.empty() || !panel.histos[0]) {
+            std::cerr << "Missing histogram for panel " << panel.header << "." << std::endl;
+            return false;
+        }
+        switch (panel.style) {
+            case PanelStyle::kMap:
+                DrawMap(panel);
+                break;
+            case PanelStyle::kSpectrum:
+                DrawSpectrum(panel, padHeight);
+                break;
+            case PanelStyle::kOverlay:
+                DrawOverlay(panel, padHeight);
+                break;
+        }
+        if (panel.header.Length() > 0) {
+            TLatex latex;
+            latex.SetTextAlign(22);
+            latex.SetTextSize(0.05);
+            latex.SetTextColor(panel.headerColor);
+            // Between the title and the frame
+            latex.DrawLatexNDC(0.5, 1 - 0.75 * gPad->GetTopMargin(), panel.header);
+        }
+        return true;
+    }
+
+    static void PlaceStats(TH1* histo, double x1, double x2, double y1, double y2) {
+        gPad->Update();
+        TPaveStats* stats = (TPaveStats*)histo->FindObject("stats");
+        if (stats) {
+            stats->SetX1NDC(x1);
+            stats->SetX2NDC(x2);
+            stats->SetY1NDC(y1);
+            stats->SetY2NDC(y2);
+        }
+    }
+
+    static void DrawMap(const ComparisonPanel& panel) {
+        TH1* histo = panel.histos[0];
+        gPad->SetLogz();
+        gPad->SetTopMargin(0.20);
+        gPad->SetRightMargin(0.12);
+        gStyle->SetPalette(kBird);
+        histo->SetMinimum(histo->GetMinimum(0));
+        histo->Draw("COLZ");
+        PlaceStats(histo, 0.75, 0.93, 0.80, 0.95);
+    }
+
+    static void DrawSpectrum(const ComparisonPanel& panel, double padHeight) {
+        TH1* histo = panel.histos[0];
+        double scale = padHeight / 3100;
+        Color_t color = panel.colors.empty() ? Color_t(kCyan-2) : panel.colors[0];
+        gPad->SetTopMargin(0.20);
+        if (panel.logY) gPad->SetLogy();
+        histo->SetLineColor(color);
+        histo->SetLineWidth(std::max(1, int(4 * scale + 0.5)));
+        histo->SetMarkerStyle(20);
+        histo->SetMarkerSize(3 * scale);
+        histo->SetMarkerColor(color);
+        histo->Draw();
+        PlaceStats(histo, 0.73, 0.90, 0.80, 0.95);
+    }
+
+    static void DrawOverlay(const ComparisonPanel& panel, double padHeight) {
+        double scale = padHeight / 4000;
+        const Style_t markers[] = {21, 22, 20};
+        gPad->SetLeftMargin(0.20);
+        gPad->SetTopMargin(0.15);
+        if (panel.logY) gPad->SetLogy();
+        TLegend* legend = new TLegend(0.25, 0.70, 0.55, 0.80);
+        legend->SetBit(kCanDelete);
+        double maximum = 0;
+        for (TH1* histo : panel.histos) {
+            if (histo) maximum = std::max(maximum, histo->GetMaximum());
+        }
+        TH1* frame = panel.histos[0];
+        frame->SetMaximum(panel.logY ? 2 * maximum : 1.1 * maximum);
+        for (size_t i = 0; i < panel.histos.size(); ++i) {
+            TH1* histo = panel.histos[i];
+            if (!histo) continue;
+            Color_t color = i < panel.colors.size() ? panel.colors[i] : Color_t(kBlack);
+            histo->SetStats(kFALSE);
+            histo->SetLineColor(color);
+            histo->SetLineWidth(std::max(1, int(20 * scale + 0.5)));
+            histo->SetMarkerColor(color);
+            histo->SetMarkerStyle(markers[i % 3]);
+            histo->SetMarkerSize(6 * scale);
+            histo->Draw(histo == frame ? "E" : "ESAME");
+            if (i < panel.labels.size()) legend->AddEntry(histo, panel.labels[i], "lep");
+        }
+        legend->Draw();
+    }
+
+    std::vector<ComparisonJob> fJobs;
+    std::vector<TH1*> fOwned;
+};
+
+#endif
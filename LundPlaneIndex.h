@@ -0,0 +1,197 @@
+#ifndef LUNDPLANEINDEX_H
+#define LUNDPLANEINDEX_H
+
+#include <TH1D.h>
+#include <TH2D.h>
+#include <TH3.h>
+#include <TAxis.h>
+#include <TString.h>
+#include <vector>
+#include <cmath>
+
+// Summed-area table over a Lund plane TH3 (x = ln(R/Delta), y = ln(kT) or ln(1/z), z = jet pT).
+// It is built once from the TH3 and then answers any (x, y, pT) box sum of contents and squared errors in constant time,
+// so a new pT bin or band boundary costs one pass over the output bins instead of a Project3D of the whole TH3 plus clones.
+// All the cells are indexed including under/overflow, as TH3 does.
+class LundPlaneIndex {
+public:
+    explicit LundPlaneIndex(const TH3* histo) : fHisto(histo) {
+        fNx = histo->GetNbinsX() + 2;
+        fNy = histo->GetNbinsY() + 2;
+        fNz = histo->GetNbinsZ() + 2;
+        // Prefix sums have one extra leading cell per dimension, so that S(-1, ., .) = 0
+        size_t size = size_t(fNx + 1) * (fNy + 1) * (fNz + 1);
+        fSum.assign(size, 0.);
+        fSumErr2.assign(size, 0.);
+        for (int k = 0; k < fNz; ++k) {
+            for (int j = 0; j < fNy; ++j) {
+                for (int i = 0; i < fNx; ++i) {
+                    double content = histo->GetBinContent(i, j, k);
+                    double error = histo->GetBinError(i, j, k);
+                    size_t c = Index(i + 1, j + 1, k + 1);
+                    // 3D inclusion-exclusion over the seven already-summed neighbours
+                    fSum[c] = content
+                        + fSum[Index(i, j + 1, k + 1)] + fSum[Index(i + 1, j, k + 1)] + fSum[Index(i + 1, j + 1, k)]
+                        - fSum[Index(i, j, k + 1)] - fSum[Index(i, j + 1, k)] - fSum[Index(i + 1, j, k)]
+                        + fSum[Index(i, j, k)];
+                    fSumErr2[c] = error * error
+                        + fSumErr2[Index(i, j + 1, k + 1)] + fSumErr2[Index(i + 1, j, k + 1)] + fSumErr2[Index(i + 1, j + 1, k)]
+                        - fSumErr2[Index(i, j, k + 1)] - fSumErr2[Index(i, j + 1, k)] - fSumErr2[Index(i + 1, j, k)]
+                        + fSumErr2[Index(i, j, k)];
+                }
+            }
+        }
+        // Cumulative bin widths, so that the width of any band is a single difference
+        BuildWidths(histo->GetXaxis(), fCumWidthX);
+        BuildWidths(histo->GetYaxis(), fCumWidthY);
+    }
+
+    // pT bin range [first, last] selected by SetRangeUser(ptMin, ptMax) on the TH3 z axis
+    void PtBinRange(double ptMin, double ptMax, int& first, int& last) const {
+        UserRange(fHisto->GetZaxis(), ptMin, ptMax, first, last);
+    }
+
+    // Full pT range, as Project3D uses when no range is set on the z axis
+    void FullPtBinRange(int& first, int& last) const {
+        first = 0;
+        last = fNz - 1;
+    }
+
+    double Sum(int x1, int x2, int y1, int y2, int z1, int z2) const {
+        return Box(fSum, x1, x2, y1, y2, z1, z2);
+    }
+
+    double SumErr2(int x1, int x2, int y1, int y2, int z1, int z2) const {
+        return Box(fSumErr2, x1, x2, y1, y2, z1, z2);
+    }
+
+    // Project3D("yx") over the pT bins [z1, z2], each bin divided by its area and by N_jets
+    TH2D* Plane(const char* name, double N_jets, int z1, int z2) const {
+        const TAxis* xAxis = fHisto->GetXaxis();
+        const TAxis* yAxis = fHisto->GetYaxis();
+        TH2D* plane = NewPlane(name, xAxis, yAxis);
+        double sumContent = 0;
+        for (int j = 0; j < fNy; ++j) {
+            for (int i = 0; i < fNx; ++i) {
+                double content = Sum(i, i, j, j, z1, z2);
+                double error = std::sqrt(SumErr2(i, i, j, j, z1, z2));
+                sumContent += content;
+                bool inRange = i >= 1 && i < fNx - 1 && j >= 1 && j < fNy - 1;
+                double binArea = inRange ? xAxis->GetBinWidth(i) * yAxis->GetBinWidth(j) : 0;
+                if (binArea > 0 && N_jets > 0) {
+                    double a = 1 / (binArea * N_jets);
+                    content *= a;
+                    error *= a;
+                }
+                plane->SetBinContent(i, j, content);
+                plane->SetBinError(i, j, error);
+            }
+        }
+        plane->SetEntries(sumContent);
+        return plane;
+    }
+
+    // Projection over y of the band FindBin(xMin) .. FindBin(xMax), divided by N_jets, the band width and the y bin width
+    TH1D* BandY(const char* name, double N_jets, double xMin, double xMax, int z1, int z2) const {
+        const TAxis* xAxis = fHisto->GetXaxis();
+        int binMinX = xAxis->FindBin(xMin);
+        int binMaxX = xAxis->FindBin(xMax);
+        double deltaX = fCumWidthX[binMaxX + 1] - fCumWidthX[binMinX];
+        return Band(name, fHisto->GetYaxis(), N_jets * deltaX, binMinX, binMaxX, z1, z2, true);
+    }
+
+    // Projection over x of the band FindBin(yMin) .. FindBin(yMax), divided by N_jets, the band width and the x bin width
+    TH1D* BandX(const char* name, double N_jets, double yMin, double yMax, int z1, int z2) const {
+        const TAxis* yAxis = fHisto->GetYaxis();
+        int binMinY = yAxis->FindBin(yMin);
+        int binMaxY = yAxis->FindBin(yMax);
+        double deltaY = fCumWidthY[binMaxY + 1] - fCumWidthY[binMinY];
+        return Band(name, fHisto->GetXaxis(), N_jets * deltaY, binMinY, binMaxY, z1, z2, false);
+    }
+
+private:
+    size_t Index(int i, int j, int k) const {
+        return (size_t(k) * (fNy + 1) + j) * (fNx + 1) + i;
+    }
+
+    // Sum over the inclusive cell box [x1, x2] x [y1, y2] x [z1, z2]
+    double Box(const std::vector<double>& s, int x1, int x2, int y1, int y2, int z1, int z2) const {
+        if (x2 < x1 || y2 < y1 || z2 < z1) return 0;
+        ++x2; ++y2; ++z2;
+        return s[Index(x2, y2, z2)]
+            - s[Index(x1, y2, z2)] - s[Index(x2, y1, z2)] - s[Index(x2, y2, z1)]
+            + s[Index(x1, y1, z2)] + s[Index(x1, y2, z1)] + s[Index(x2, y1, z1)]
+            - s[Index(x1, y1, z1)];
+    }
+
+    static void BuildWidths(const TAxis* axis, std::vector<double>& cumWidth) {
+        // cumWidth[b + 1] = sum of the widths of bins 0..b, with a leading zero cell as the sums. A band that starts in
+        // the underflow or ends in the overflow counts them with the width TAxis::GetBinWidth gives them, as the
+        // bin by bin loop of the band projections did.
+        int n = axis->GetNbins();
+        cumWidth.assign(n + 3, 0.);
+        for (int b = 0; b <= n + 1; ++b) {
+            cumWidth[b + 1] = cumWidth[b] + axis->GetBinWidth(b);
+        }
+    }
+
+    // Bin selection of TAxis::SetRangeUser
+    static void UserRange(const TAxis* axis, double uMin, double uMax, int& first, int& last) {
+        first = axis->FindFixBin(uMin);
+        last = axis->FindFixBin(uMax);
+        if (axis->GetBinUpEdge(first) <= uMin) first += 1;
+        if (axis->GetBinLowEdge(last) >= uMax) last -= 1;
+    }
+
+    static TH2D* NewPlane(const char* name, const TAxis* xAxis, const TAxis* yAxis) {
+        std::vector<double> edgesX, edgesY;
+        AxisEdges(xAxis, edgesX);
+        AxisEdges(yAxis, edgesY);
+        TH2D* plane = new TH2D(name, "", edgesX.size() - 1, edgesX.data(), edgesY.size() - 1, edgesY.data());
+        plane->SetDirectory(nullptr);
+        plane->Sumw2();
+        return plane;
+    }
+
+    static void AxisEdges(const TAxis* axis, std::vector<double>& edges) {
+        edges.clear();
+        for (int b = 1; b <= axis->GetNbins(); ++b) {
+            edges.push_back(axis->GetBinLowEdge(b));
+        }
+        edges.push_back(axis->GetBinUpEdge(axis->GetNbins()));
+    }
+
+    TH1D* Band(const char* name, const TAxis* outAxis, double norm, int bandMin, int bandMax, int z1, int z2, bool alongY) const {
+        std::vector<double> edges;
+        AxisEdges(outAxis, edges);
+        TH1D* proj = new TH1D(name, "", edges.size() - 1, edges.data());
+        proj->SetDirectory(nullptr);
+        proj->Sumw2();
+        double sumContent = 0;
+        for (int b = 0; b <= outAxis->GetNbins() + 1; ++b) {
+            double sum = alongY ? Sum(bandMin, bandMax, b, b, z1, z2) : Sum(b, b, bandMin, bandMax, z1, z2);
+            double errorSumSquared = alongY ? SumErr2(bandMin, bandMax, b, b, z1, z2) : SumErr2(b, b, bandMin, bandMax, z1, z2);
+            sumContent += sum;
+            if (b < 1 || b > outAxis->GetNbins()) {
+                // Under/overflow keep the raw projection, as ProjectionX/Y does before the rescaling
+                proj->SetBinContent(b, sum);
+                proj->SetBinError(b, std::sqrt(errorSumSquared));
+                continue;
+            }
+            double binWidth = outAxis->GetBinWidth(b);
+            proj->SetBinContent(b, sum / (norm * binWidth));
+            proj->SetBinError(b, std::sqrt(errorSumSquared) / (norm * binWidth));
+        }
+        proj->SetEntries(sumContent);
+        return proj;
+    }
+
+    const TH3* fHisto;
+    int fNx, fNy, fNz;
+    std::vector<double> fSum;
+    std::vector<double> fSumErr2;
+    std::vector<double> fCumWidthX;
+    std::vector<double> fCumWidthY;
+};
+
+#endif
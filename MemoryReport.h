@@ -0,0 +1,46 @@
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <TSystem.h>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include "AnalysisInput.h"
+#include "PlotArena.h"
+
+// Resident set size of the process in MB
+inline double CurrentRSS() {
+    ProcInfo_t info;
+    gSystem->GetProcInfo(&info);
+    return info.fMemResident / 1024.;
+}
+
+// Peak resident set size of the process in MB (VmHWM of /proc/self/status, Linux only), 0 if not available
+inline double PeakRSS() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::atof(line.c_str() + 6) / 1024;
+    }
+    return 0;
+}
+
+// Resets the peak RSS to the current RSS, so that each stage reports its own peak. Where this is not supported the peak
+// of a stage is the peak of the process so far.
+inline void ResetPeakRSS() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+// Per-stage memory line, printed when QA_MEMORY_REPORT is set: objects alive in plot arenas, source objects kept by the
+// input and the RSS of the process (of the worker, for the selections processed in parallel)
+inline void ReportMemory(const char* stage, const AnalysisInput* input = nullptr) {
+    if (!gSystem->Getenv("QA_MEMORY_REPORT")) return;
+    printf("[memory] %-45s %6ld live objects", stage, PlotArena::LiveObjects());
+    if (input) printf(" | %4zu source objects (%8.1f MB)", input->KeptObjects(), input->KeptMegabytes());
+    printf(" | RSS %8.1f MB, peak %8.1f MB\n", CurrentRSS(), PeakRSS());
+    fflush(stdout);
+}
+
+#endif
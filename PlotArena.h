@@ -0,0 +1,54 @@
+#ifndef PLOTARENA_H
+#define PLOTARENA_H
+
+#include <TObject.h>
+#include <TH1.h>
+#include <vector>
+#include "AnalysisInput.h"
+
+// Owner of the intermediate objects of one plot or output file: projections, clones, ratios, legends, lines and canvases.
+// They are deleted in reverse order of adoption on Release(), or when the arena goes out of scope, i.e. right after the
+// SaveAs / Write they were made for. An arena tied to an AnalysisInput trims its source objects to the memory budget
+// after the release (AnalysisInput::Trim), when no pointer to them is held anymore.
+class PlotArena {
+public:
+    explicit PlotArena(AnalysisInput* input = nullptr) : fInput(input) {}
+    ~PlotArena() {
+        Release();
+    }
+    PlotArena(const PlotArena&) = delete;
+    PlotArena& operator=(const PlotArena&) = delete;
+
+    // Takes ownership of the object and detaches histograms from their directory, returns it for convenience
+    template <class T>
+    T* Own(T* obj) {
+        if (!obj) return nullptr;
+        if (TH1* histo = dynamic_cast<TH1*>(static_cast<TObject*>(obj))) histo->SetDirectory(nullptr);
+        fObjects.push_back(obj);
+        ++LiveObjects();
+        return obj;
+    }
+
+    void Release() {
+        for (auto it = fObjects.rbegin(); it != fObjects.rend(); ++it) {
+            delete *it;
+        }
+        LiveObjects() -= fObjects.size();
+        fObjects.clear();
+        if (fInput) fInput->Trim();
+    }
+
+    size_t Size() const { return fObjects.size(); }
+
+    // Objects owned by all the arenas of the process
+    static long& LiveObjects() {
+        static long live = 0;
+        return live;
+    }
+
+private:
+    AnalysisInput* fInput;
+    std::vector<TObject*> fObjects;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef PROJECTIONSINK_H
+#define PROJECTIONSINK_H
+
+#include <TFile.h>
+#include <TH1.h>
+#include <TString.h>
+#include <vector>
+#include <iostream>
+
+// Collects the projections of one selection in memory and writes them with a single TFile open.
+// The output file is recreated on Write(), so reruns do not pile up key cycles as the old "UPDATE" writes did.
+class ProjectionSink {
+public:
+    explicit ProjectionSink(const char* fileName) : fFileName(fileName) {}
+    ~ProjectionSink() {
+        Clear();
+    }
+    ProjectionSink(const ProjectionSink&) = delete;
+    ProjectionSink& operator=(const ProjectionSink&) = delete;
+
+    // Takes ownership of the histogram
+    void Add(TH1* histo) {
+        if (!histo) return;
+        histo->SetDirectory(nullptr);
+        fHistos.push_back(histo);
+    }
+
+    bool Write() {
+        TFile* outFile = TFile::Open(fFileName, "RECREATE");
+        if (!outFile || outFile->IsZombie()) {
+            std::cerr << "Error opening output file " << fFileName << "." << std::endl;
+            delete outFile;
+            return false;
+        }
+        outFile->cd();
+        for (TH1* histo : fHistos) {
+            histo->Write(histo->GetName(), TObject::kOverwrite);
+        }
+        outFile->Close();
+        delete outFile;
+        Clear();
+        return true;
+    }
+
+    size_t Size() const { return fHistos.size(); }
+    const char* GetFileName() const { return fFileName.Data(); }
+
+private:
+    void Clear() {
+        for (TH1* histo : fHistos) {
+            delete histo;
+        }
+        fHistos.clear();
+    }
+
+    TString fFileName;
+    std::vector<TH1*> fHistos;
+};
+
+#endif
@@ -0,0 +1,410 @@
+#ifndef RESULTMERGER_H
+#define RESULTMERGER_H
+
+#include <Rtypes.h>
+#include <TFile.h>
+#include <TDirectory.h>
+#include <TKey.h>
+#include <TClass.h>
+#include <TList.h>
+#include <TH1.h>
+#include <THnBase.h>
+#include <TRegexp.h>
+#include <TString.h>
+#include <TSystem.h>
+#include <ROOT/TProcessExecutor.hxx>
+#include <ROOT/TSeq.hxx>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <numeric>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <iostream>
+#include "AnalysisInput.h"
+#include "BinnedCache.h"
+
+namespace ResultMerger {
+
+// Keys read by the plotting macros, as path prefixes: a directory is merged with all its content, anything else by name
+inline const std::vector<std::string>& DefaultKeys() {
+    static const std::vector<std::string> keys = {"track-jet-qa_", "jet-finder-charged-qa/h_jet_pt", "jet-lund-reclustering/PrimaryLundPlane_"};
+    return keys;
+}
+
+// Sum of the selected histograms and sparses of several AnalysisResults.root files, keyed by their path in the file
+class MergedResults {
+public:
+    explicit MergedResults(const std::vector<std::string>& keys = DefaultKeys()) : fKeys(keys) {}
+    ~MergedResults() {
+        for (auto& object : fObjects) {
+            delete object.second;
+        }
+    }
+    MergedResults(const MergedResults&) = delete;
+    MergedResults& operator=(const MergedResults&) = delete;
+
+    // Adds the selected objects of the file to the sum
+    bool AddFile(const char* fileName) {
+        TFile* file = TFile::Open(fileName);
+        if (!file || file->IsZombie()) {
+            std::cerr << "Error opening file " << fileName << "." << std::endl;
+            delete file;
+            return false;
+        }
+        bool merged = Collect(file, "");
+        file->Close();
+        delete file;
+        if (!merged) std::cerr << "Error merging file " << fileName << "." << std::endl;
+        return merged;
+    }
+
+    // Writes the sum with the directory structure of the inputs
+    bool Write(const char* fileName) const {
+        TFile* file = TFile::Open(fileName, "RECREATE");
+        if (!file || file->IsZombie()) {
+            std::cerr << "Error creating file " << fileName << "." << std::endl;
+            delete file;
+            return false;
+        }
+        bool written = true;
+        for (const auto& object : fObjects) {
+            size_t slash = object.first.rfind('/');
+            TDirectory* dir = slash == std::string::npos ? file : MakeDirectory(file, object.first.substr(0, slash));
+            std::string name = slash == std::string::npos ? object.first : object.first.substr(slash + 1);
+            written &= dir && dir->WriteTObject(object.second, name.c_str()) > 0;
+        }
+        file->Close();
+        delete file;
+        if (!written) std::cerr << "Error writing file " << fileName << "." << std::endl;
+        return written;
+    }
+
+    // Writes the binned cache of fileName (see AnalysisInput.h) straight from the merged objects, so the first plotting
+    // macro run on the merged file does not have to read it back
+    bool WriteCache(const char* fileName) const {
+        int64_t size = 0, mtime = 0;
+        if (!AnalysisInput::CacheEnabled() || !BinnedCache::SourceStat(fileName, size, mtime)) return false;
+        TString cacheFile = AnalysisInput::CachePath(fileName);
+        gSystem->mkdir(gSystem->GetDirName(cacheFile), kTRUE);
+        TString tmpFile = TString::Format("%s.tmp%d", cacheFile.Data(), gSystem->GetPid());
+        BinnedCache::Writer writer(tmpFile);
+        bool written = writer.IsOpen();
+        for (const auto& object : fObjects) {
+            if (!written) break;
+            writer.Add(object.first, object.second);
+        }
+        written = written && writer.Finish(size, mtime);
+        if (!written || std::rename(tmpFile.Data(), cacheFile.Data()) != 0) {
+            std::cerr << "Error writing binned cache " << cacheFile << "." << std::endl;
+            gSystem->Unlink(tmpFile);
+            return false;
+        }
+        return true;
+    }
+
+    size_t Size() const { return fObjects.size(); }
+
+private:
+    // Directories on the way to a selected key are walked, objects are kept if their path starts with a selected key
+    bool Selected(const std::string& path, bool isDirectory) const {
+        for (const std::string& key : fKeys) {
+            if (path.compare(0, key.size(), key) == 0) return true;
+            if (isDirectory && key.compare(0, path.size() + 1, path + "/") == 0) return true;
+        }
+        return false;
+    }
+
+    bool Collect(TDirectory* dir, const std::string& path) {
+        std::set<std::string> seen;
+        TIter next(dir->GetListOfKeys());
+        while (TKey* key = static_cast<TKey*>(next())) {
+            // Keys are sorted by decreasing cycle, only the latest cycle of each name is merged
+            if (!seen.insert(key->GetName()).second) continue;
+            std::string name = path.empty() ? key->GetName() : path + "/" + key->GetName();
+            TClass* cl = TClass::GetClass(key->GetClassName());
+            if (!cl) continue;
+            bool isDirectory = cl->InheritsFrom(TDirectory::Class());
+            if (!Selected(name, isDirectory)) continue;
+            if (isDirectory) {
+                TDirectory* subDir = dir->GetDirectory(key->GetName());
+                if (subDir && !Collect(subDir, name)) return false;
+            } else if (cl->InheritsFrom(TH1::Class()) || cl->InheritsFrom(THnBase::Class())) {
+                TObject* obj = key->ReadObj();
+                // The sum outlives the input file
+                if (TH1* histo = dynamic_cast<TH1*>(obj)) histo->SetDirectory(nullptr);
+                if (!Add(name, obj)) return false;
+            }
+        }
+        return true;
+    }
+
+    // Takes ownership of obj
+    bool Add(const std::string& name, TObject* obj) {
+        auto merged = fObjects.find(name);
+        if (merged == fObjects.end()) {
+            fObjects[name] = obj;
+            return true;
+        }
+        TList list;
+        list.Add(obj);
+        Long64_t result = -1;
+        if (TH1* histo = dynamic_cast<TH1*>(merged->second)) {
+            result = histo->Merge(&list);
+        } else if (THnBase* sparse = dynamic_cast<THnBase*>(merged->second)) {
+            result = sparse->Merge(&list);
+        }
+        delete obj;
+        if (result < 0) std::cerr << "Cannot merge " << name << ", the binning differs between the inputs." << std::endl;
+        return result >= 0;
+    }
+
+    static TDirectory* MakeDirectory(TDirectory* top, const std::string& path) {
+        TDirectory* dir = top;
+        std::stringstream components(path);
+        std::string component;
+        while (dir && std::getline(components, component, '/')) {
+            TDirectory* subDir = dir->GetDirectory(component.c_str());
+            dir = subDir ? subDir : dir->mkdir(component.c_str());
+        }
+        return dir;
+    }
+
+    std::vector<std::string> fKeys;
+    std::map<std::string, TObject*> fObjects;
+};
+
+// Expands the wildcards of a path, in any component (e.g. "runs/5*/AnalysisResults.root")
+inline std::vector<std::string> ExpandGlob(const std::string& pattern) {
+    std::vector<std::string> paths = {pattern.compare(0, 1, "/") == 0 ? "/" : ""};
+    std::stringstream components(pattern);
+    std::string component;
+    auto join = [](const std::string& dir, const std::string& name) {
+        return dir.empty() ? name : dir.back() == '/' ? dir + name : dir + "/" + name;
+    };
+    while (std::getline(components, component, '/')) {
+        if (component.empty()) continue;
+        std::vector<std::string> expanded;
+        if (!TString(component).MaybeWildcard()) {
+            for (const std::string& path : paths) {
+                expanded.push_back(join(path, component));
+            }
+        } else {
+            TRegexp regexp(component.c_str(), kTRUE);
+            for (const std::string& path : paths) {
+                void* dir = gSystem->OpenDirectory(path.empty() ? "." : path.c_str());
+                if (!dir) continue;
+                while (const char* entry = gSystem->GetDirEntry(dir)) {
+                    TString name = entry;
+                    Ssiz_t length = 0;
+                    if (name == "." || name == ".." || name.Index(regexp, &length) != 0 || length != name.Length()) continue;
+                    expanded.push_back(join(path, entry));
+                }
+                gSystem->FreeDirectory(dir);
+            }
+        }
+        paths.swap(expanded);
+    }
+    // AccessPathName returns true when the path does not exist
+    paths.erase(std::remove_if(paths.begin(), paths.end(), [](const std::string& path) { return gSystem->AccessPathName(path.c_str()); }), paths.end());
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Input files given as a single ROOT file, a wildcard pattern, or a text file with one path per line (# for comments)
+inline std::vector<std::string> InputFiles(const char* inputs) {
+    TString spec = inputs;
+    if (spec.MaybeWildcard()) return ExpandGlob(inputs);
+    if (spec.EndsWith(".root")) return {inputs};
+    std::vector<std::string> files;
+    std::ifstream list(inputs);
+    if (!list) {
+        std::cerr << "Error opening file list " << inputs << "." << std::endl;
+        return files;
+    }
+    std::string line;
+    while (std::getline(list, line)) {
+        TString path = TString(line.c_str()).Strip(TString::kBoth);
+        if (path.Length() > 0 && !path.BeginsWith("#")) files.push_back(path.Data());
+    }
+    return files;
+}
+
+struct FileStamp {
+    int64_t size = 0;
+    int64_t mtime = 0;
+    bool operator==(const FileStamp& other) const { return size == other.size && mtime == other.mtime; }
+};
+
+// Inputs already summed into the output, with the size and modification time they had when they were merged, and the
+// keys the output was filtered with
+struct Manifest {
+    FileStamp output;
+    std::map<std::string, FileStamp> inputs;
+    std::set<std::string> keys;
+
+    static TString PathFor(const char* outputFile) {
+        return TString::Format("%s.manifest", outputFile);
+    }
+
+    bool Read(const char* fileName) {
+        std::ifstream in(fileName);
+        if (!in) return false;
+        std::string kind, path;
+        FileStamp stamp;
+        bool hasOutput = false;
+        while (in >> kind >> stamp.size >> stamp.mtime && std::getline(in >> std::ws, path)) {
+            if (kind == "output") {
+                output = stamp;
+                hasOutput = true;
+            } else if (kind == "input") {
+                inputs[path] = stamp;
+            } else if (kind == "key") {
+                keys.insert(path);
+            }
+        }
+        return hasOutput;
+    }
+
+    bool Write(const char* fileName, const char* outputFile) const {
+        std::ofstream out(fileName, std::ios::trunc);
+        out << "output " << output.size << " " << output.mtime << " " << outputFile << "\n";
+        for (const auto& input : inputs) {
+            out << "input " << input.second.size << " " << input.second.mtime << " " << input.first << "\n";
+        }
+        for (const std::string& key : keys) {
+            out << "key 0 0 " << key << "\n";
+        }
+        return out.good();
+    }
+};
+
+inline bool Stamp(const std::string& fileName, FileStamp& stamp) {
+    return BinnedCache::SourceStat(fileName.c_str(), stamp.size, stamp.mtime);
+}
+
+// Contiguous groups of files, as even as possible
+inline std::vector<std::vector<std::string>> SplitGroups(const std::vector<std::string>& files, size_t nGroups) {
+    std::vector<std::vector<std::string>> groups(nGroups);
+    for (size_t i = 0; i < files.size(); ++i) {
+        groups[i * nGroups / files.size()].push_back(files[i]);
+    }
+    return groups;
+}
+
+// Sums inputs into outputFile. With parallel = true the inputs are reduced as a tree: at each level forked workers
+// (ROOT::TProcessExecutor) merge groups of files into partial files, halving their number until the parent merges the
+// last ones. If the manifest of a previous merge shows that none of its inputs changed and that it used the same keys,
+// only the new inputs are added to the existing output. The binned cache of the output is written at the end, ready for the plotting macros.
+inline bool Merge(const std::vector<std::string>& inputs, const char* outputFile, bool parallel = true, const std::vector<std::string>& keys = DefaultKeys()) {
+    Manifest manifest;
+    for (const std::string& input : inputs) {
+        FileStamp stamp;
+        if (!Stamp(input, stamp)) {
+            std::cerr << "Cannot access " << input << "." << std::endl;
+            return false;
+        }
+        manifest.inputs[input] = stamp;
+    }
+    manifest.keys.insert(keys.begin(), keys.end());
+
+    std::vector<std::string> toMerge;
+    Manifest previous;
+    FileStamp outputStamp;
+    TString manifestFile = Manifest::PathFor(outputFile);
+    bool incremental = previous.Read(manifestFile) && Stamp(outputFile, outputStamp) && outputStamp == previous.output;
+    // An output filtered with other keys has to be merged again from its inputs, or it would mix the two filters
+    incremental &= previous.keys == manifest.keys;
+    // A sum cannot lose an input: a removed or modified input means merging everything again
+    for (const auto& input : previous.inputs) {
+        auto current = manifest.inputs.find(input.first);
+        incremental &= current != manifest.inputs.end() && current->second == input.second;
+    }
+    if (incremental) {
+        for (const auto& input : manifest.inputs) {
+            if (!previous.inputs.count(input.first)) toMerge.push_back(input.first);
+        }
+        if (toMerge.empty()) {
+            std::cout << outputFile << " is up to date with its " << inputs.size() << " inputs." << std::endl;
+            AnalysisInput::PrepareCache(outputFile);
+            return true;
+        }
+        std::cout << "Adding " << toMerge.size() << " new inputs to " << outputFile << "." << std::endl;
+        toMerge.insert(toMerge.begin(), outputFile);
+    } else {
+        toMerge = inputs;
+        std::cout << "Merging " << toMerge.size() << " inputs into " << outputFile << "." << std::endl;
+    }
+
+    TString workDir = TString::Format("%s.merge%d", outputFile, gSystem->GetPid());
+    std::vector<std::string> partials;
+    auto removePartials = [&]() {
+        for (const std::string& partial : partials) {
+            gSystem->Unlink(partial.c_str());
+        }
+        partials.clear();
+    };
+
+    if (parallel && toMerge.size() > 3) {
+        SysInfo_t sysInfo;
+        gSystem->GetSysInfo(&sysInfo);
+        size_t nWorkers = std::max(1, sysInfo.fCpus);
+        gSystem->mkdir(workDir, kTRUE);
+        for (int level = 0; toMerge.size() > 3; ++level) {
+            size_t nGroups = std::min(nWorkers, toMerge.size() / 2);
+            std::vector<std::vector<std::string>> groups = SplitGroups(toMerge, nGroups);
+            std::vector<std::string> merged;
+            for (size_t i = 0; i < nGroups; ++i) {
+                merged.push_back(TString::Format("%s/level%d_%zu.root", workDir.Data(), level, i).Data());
+            }
+            auto mergeGroup = [&](int i) -> int {
+                MergedResults sum(keys);
+                for (const std::string& file : groups[i]) {
+                    if (!sum.AddFile(file.c_str())) return 0;
+                }
+                return sum.Write(merged[i].c_str()) ? 1 : 0;
+            };
+            ROOT::TProcessExecutor workers(std::min(nWorkers, nGroups));
+            std::vector<int> written = workers.Map(mergeGroup, ROOT::TSeqI(nGroups));
+            // The files of the previous level are not needed anymore, the original inputs are never removed
+            removePartials();
+            partials = merged;
+            if (std::accumulate(written.begin(), written.end(), 0) != int(nGroups)) {
+                removePartials();
+                gSystem->Unlink(workDir);
+                return false;
+            }
+            toMerge = merged;
+        }
+    }
+
+    MergedResults sum(keys);
+    bool merged = true;
+    for (const std::string& file : toMerge) {
+        merged = merged && sum.AddFile(file.c_str());
+    }
+    removePartials();
+    gSystem->Unlink(workDir);
+    if (!merged) return false;
+
+    // The output is replaced only once the sum is complete, it can be one of the inputs of an incremental merge
+    TString tmpFile = TString::Format("%s.tmp%d.root", outputFile, gSystem->GetPid());
+    if (!sum.Write(tmpFile) || std::rename(tmpFile.Data(), outputFile) != 0) {
+        gSystem->Unlink(tmpFile);
+        return false;
+    }
+    if (!Stamp(outputFile, manifest.output) || !manifest.Write(manifestFile, outputFile)) {
+        std::cerr << "Error writing manifest " << manifestFile << ", the next merge will start from scratch." << std::endl;
+        gSystem->Unlink(manifestFile);
+    }
+    sum.WriteCache(outputFile);
+    std::cout << sum.Size() << " objects from " << inputs.size() << " inputs written to " << outputFile << "." << std::endl;
+    return true;
+}
+
+} // namespace ResultMerger
+
+#endif
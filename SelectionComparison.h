@@ -0,0 +1,181 @@
+#ifndef SELECTIONCOMPARISON_H
+#define SELECTIONCOMPARISON_H
+
+#include <TH1D.h>
+#include <TArrayD.h>
+#include <TMath.h>
+#include <TString.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Projection files of each selection (<prefix>_<selection>.root): QAplay.C writes them from this list and
+// CompareSelections.C reads them back. A projection is named <observable>_Proj2D_<axis1>_<axis2>_py_<ptMin>_<ptMax>.
+struct ProjectedObservable {
+    const char* name;
+    const char* directory;  // of the sparse in track-jet-qa_<selection id>
+    int axis1;
+    int axis2;
+    bool logY;
+
+    TString Path() const { return TString::Format("%s/%s", directory, name); }
+};
+
+struct ProjectionSet {
+    const char* prefix;
+    bool perTrackNormalization;  // projections normalized to the tracks of their pT bin instead of to the events
+    std::vector<std::pair<double, double>> ptBins;
+    std::vector<ProjectedObservable> observables;
+};
+
+inline const std::vector<ProjectionSet>& ProjectionSets() {
+    static const std::vector<ProjectionSet> sets = {
+        {"projections", false, {{0, 1}, {1, 3}, {3, 5}, {5, 10}, {10, 50}, {50, 100}, {100, 200}}, {
+            {"tpcNClsFindable", "TPC", 2, 0, false},
+            {"tpcNClsFound", "TPC", 2, 0, false},
+            {"tpcNClsShared", "TPC", 2, 0, true},
+            {"tpcNClsCrossedRows", "TPC", 2, 0, true},
+            {"tpcFractionSharedCls", "TPC", 2, 0, true},
+            {"tpcCrossedRowsOverFindableCls", "TPC", 2, 0, true},
+            {"tpcChi2NCl", "TPC", 2, 0, true},
+            {"itsHits", "ITS", 2, 0, false},
+            {"itsNCls", "ITS", 2, 0, false},
+            {"itsChi2NCl", "ITS", 2, 0, true}
+        }},
+        {"projections_sigma1pT", true, {{0, 10}, {10, 80}, {80, 200}}, {
+            {"Sigma1Pt_Layers12", "TrackPar", 1, 0, true},
+            {"Sigma1Pt_Layers456", "TrackPar", 1, 0, true}
+        }}
+    };
+    return sets;
+}
+
+inline TString ProjectionName(const ProjectedObservable& observable, double ptMin, double ptMax) {
+    return TString::Format("%s_Proj2D_%d_%d_py_%g_%g", observable.name, observable.axis1, observable.axis2, ptMin, ptMax);
+}
+
+// Pairs of selections compared, as indices in TrackSelections(): numerator / denominator of the ratio
+inline const std::vector<std::pair<int, int>>& SelectionPairs() {
+    static const std::vector<std::pair<int, int>> pairs = {
+        {1, 2},  // tight / GlobalTracks
+        {0, 2},  // loose / GlobalTracks
+        {0, 1}   // loose / tight
+    };
+    return pairs;
+}
+
+// Bin contents and squared errors of a histogram without under- and overflow, copied once into contiguous arrays so
+// that every comparison of the histogram runs over plain arrays
+struct BinnedValues {
+    std::vector<double> contents;
+    std::vector<double> errors2;
+
+    static BinnedValues From(TH1D* histo) {
+        BinnedValues values;
+        int nBins = histo->GetNbinsX();
+        const double* contents = histo->GetArray();
+        const double* errors2 = histo->GetSumw2N() ? histo->GetSumw2()->GetArray() : contents;
+        values.contents.assign(contents + 1, contents + nBins + 1);
+        values.errors2.assign(errors2 + 1, errors2 + nBins + 1);
+        return values;
+    }
+
+    size_t Size() const { return contents.size(); }
+};
+
+// Compatibility of two selections in one observable and pT bin. The yield ratio compares the normalizations, the
+// chi2 and the Kolmogorov test compare the shapes: the denominator is scaled to the integral of the numerator.
+struct CompatibilityResult {
+    double yieldRatio = 0;
+    double chi2 = 0;
+    int ndf = 0;
+    double ksDistance = 0;
+    double ksProbability = 1;
+    double maxPull = 0;     // largest |numerator - scaled denominator| / error over the bins
+    bool emptySide = false; // one of the two selections has no entries in the bin, the other has
+
+    double Chi2PerNdf() const { return ndf > 0 ? chi2 / ndf : 0; }
+};
+
+// numerator / denominator per bin, with uncorrelated errors as TH1::Divide; bins with an empty denominator are 0
+inline void ComputeRatio(const BinnedValues& numerator, const BinnedValues& denominator, std::vector<double>& ratio, std::vector<double>& errors) {
+    size_t nBins = std::min(numerator.Size(), denominator.Size());
+    ratio.assign(nBins, 0);
+    errors.assign(nBins, 0);
+    const double* a = numerator.contents.data();
+    const double* a2 = numerator.errors2.data();
+    const double* b = denominator.contents.data();
+    const double* b2 = denominator.errors2.data();
+    for (size_t i = 0; i < nBins; ++i) {
+        if (b[i] == 0) continue;
+        double r = a[i] / b[i];
+        ratio[i] = r;
+        errors[i] = std::sqrt(a2[i] * b[i] * b[i] + b2[i] * a[i] * a[i]) / (b[i] * b[i]);
+    }
+}
+
+// Binned chi2 and Kolmogorov test in one pass over the bins; the Kolmogorov probability uses the effective number of
+// entries of each histogram, as TH1::KolmogorovTest does for weighted histograms
+inline CompatibilityResult ComputeCompatibility(const BinnedValues& numerator, const BinnedValues& denominator) {
+    CompatibilityResult result;
+    size_t nBins = std::min(numerator.Size(), denominator.Size());
+    const double* a = numerator.contents.data();
+    const double* a2 = numerator.errors2.data();
+    const double* b = denominator.contents.data();
+    const double* b2 = denominator.errors2.data();
+    double sumA = 0, sumA2 = 0, sumB = 0, sumB2 = 0;
+    for (size_t i = 0; i < nBins; ++i) {
+        sumA += a[i];
+        sumA2 += a2[i];
+        sumB += b[i];
+        sumB2 += b2[i];
+    }
+    // Both empty is compatible; only one empty is the most incompatible case, with no shape to compare
+    if (sumA <= 0 && sumB <= 0) return result;
+    if (sumA <= 0 || sumB <= 0) {
+        result.emptySide = true;
+        result.yieldRatio = sumB > 0 ? 0 : std::numeric_limits<double>::infinity();
+        result.chi2 = std::numeric_limits<double>::infinity();
+        result.ndf = 1;
+        result.ksDistance = 1;
+        result.ksProbability = 0;
+        return result;
+    }
+    result.yieldRatio = sumA / sumB;
+    double scale = sumA / sumB;
+    double cumulativeA = 0, cumulativeB = 0;
+    int usedBins = 0;
+    for (size_t i = 0; i < nBins; ++i) {
+        double variance = a2[i] + scale * scale * b2[i];
+        if (variance > 0) {
+            double difference = a[i] - scale * b[i];
+            result.chi2 += difference * difference / variance;
+            result.maxPull = std::max(result.maxPull, std::fabs(difference) / std::sqrt(variance));
+            ++usedBins;
+        }
+        cumulativeA += a[i];
+        cumulativeB += b[i];
+        result.ksDistance = std::max(result.ksDistance, std::fabs(cumulativeA / sumA - cumulativeB / sumB));
+    }
+    result.ndf = std::max(0, usedBins - 1);
+    double entriesA = sumA2 > 0 ? sumA * sumA / sumA2 : 0;
+    double entriesB = sumB2 > 0 ? sumB * sumB / sumB2 : 0;
+    if (entriesA > 0 && entriesB > 0) {
+        result.ksProbability = TMath::KolmogorovProb(result.ksDistance * std::sqrt(entriesA * entriesB / (entriesA + entriesB)));
+    }
+    return result;
+}
+
+// Thresholds above which a comparison is flagged for review
+struct ComparisonThresholds {
+    double chi2PerNdf = 3;
+    double ksProbability = 0.01;    // flagged below
+
+    bool Flags(const CompatibilityResult& result) const {
+        return result.emptySide || result.Chi2PerNdf() > chi2PerNdf || result.ksProbability < ksProbability;
+    }
+};
+
+#endif
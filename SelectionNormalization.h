@@ -0,0 +1,96 @@
+#ifndef SELECTIONNORMALIZATION_H
+#define SELECTIONNORMALIZATION_H
+
+#include <TH1D.h>
+#include <THnSparse.h>
+#include <TString.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <iostream>
+#include "SparseProjector.h"
+#include "AnalysisInput.h"
+
+// Normalization inputs of one track selection (id9646 = loose, id9647 = tight, id9648 = GlobalTracks):
+// the number of events from EventProp/collisionVtxZ and the track pT spectrum from Kine/pt.
+struct SelectionNormalizationEntry {
+    bool valid = false;
+    double numberOfEvents = 0;
+    TH1D* pt = nullptr;
+    std::map<std::pair<double, double>, double> ptIntegrals;
+};
+
+// Computes the normalization of each selection once and serves it to every SaveProjection_* / plotting call,
+// instead of projecting Kine/pt and EventProp/collisionVtxZ again for each observable.
+class SelectionNormalization {
+public:
+    explicit SelectionNormalization(AnalysisInput* file) : fFile(file) {}
+    ~SelectionNormalization() {
+        for (auto& entry : fEntries) {
+            delete entry.second.pt;
+        }
+    }
+    SelectionNormalization(const SelectionNormalization&) = delete;
+    SelectionNormalization& operator=(const SelectionNormalization&) = delete;
+
+    // Number of events of the selection, 0 if it could not be determined
+    double NumberOfEvents(const char* selectionId) {
+        const SelectionNormalizationEntry& entry = Load(selectionId);
+        return entry.numberOfEvents;
+    }
+
+    // Number of tracks with ptMin <= pT < ptMax, using the same bin convention as Project2DRange
+    double PtIntegral(const char* selectionId, double ptMin, double ptMax) {
+        SelectionNormalizationEntry& entry = Load(selectionId);
+        if (!entry.pt) return 0;
+        auto key = std::make_pair(ptMin, ptMax);
+        auto it = entry.ptIntegrals.find(key);
+        if (it != entry.ptIntegrals.end()) return it->second;
+        int binMin = entry.pt->GetXaxis()->FindBin(ptMin);
+        int binMax = entry.pt->GetXaxis()->FindBin(ptMax) - 1;
+        double integral = entry.pt->Integral(binMin, binMax);
+        entry.ptIntegrals[key] = integral;
+        return integral;
+    }
+
+    // Projected Kine/pt spectrum of the selection (owned by the cache)
+    TH1D* Pt(const char* selectionId) {
+        return Load(selectionId).pt;
+    }
+
+private:
+    SelectionNormalizationEntry& Load(const char* selectionId) {
+        auto it = fEntries.find(selectionId);
+        if (it != fEntries.end()) return it->second;
+        SelectionNormalizationEntry& entry = fEntries[selectionId];
+        if (!fFile) return entry;
+
+        THnSparse* collisionVtxZSparse = dynamic_cast<THnSparse*>(fFile->Get(TString::Format("track-jet-qa_%s/EventProp/collisionVtxZ", selectionId)));
+        if (!collisionVtxZSparse) {
+            std::cerr << "collisionVtxZ THnSparseD histogram not found for " << selectionId << "." << std::endl;
+        } else {
+            TH1D* collisionVtxZ = dynamic_cast<TH1D*>(collisionVtxZSparse->Projection(0));
+            if (!collisionVtxZ) {
+                std::cerr << "Projection of collisionVtxZ failed for " << selectionId << "." << std::endl;
+            } else {
+                entry.numberOfEvents = collisionVtxZ->GetEntries();
+                delete collisionVtxZ;
+            }
+        }
+
+        THnSparse* hPtSparse = dynamic_cast<THnSparse*>(fFile->Get(TString::Format("track-jet-qa_%s/Kine/pt", selectionId)));
+        if (!hPtSparse) {
+            std::cerr << "pt THnSparseD histogram not found for " << selectionId << "." << std::endl;
+        } else {
+            SparseProjectionResult projection = ProjectSlices(hPtSparse, {{0, -1, 0, 0}});
+            entry.pt = projection.hists1D[0];
+        }
+        entry.valid = entry.numberOfEvents > 0 && entry.pt;
+        return entry;
+    }
+
+    AnalysisInput* fFile;
+    std::map<std::string, SelectionNormalizationEntry> fEntries;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SELECTIONRUNNER_H
+#define SELECTIONRUNNER_H
+
+#include <Rtypes.h>
+#include <TROOT.h>
+#include <TSystem.h>
+#include <TString.h>
+#include <ROOT/TProcessExecutor.hxx>
+#include <ROOT/TSeq.hxx>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <iostream>
+#include "AnalysisInput.h"
+
+// Track selections of the track-jet-qa task
+struct TrackSelection {
+    const char* id;      // directory suffix in AnalysisResults.root, track-jet-qa_<id>
+    const char* name;    // output directory / file suffix
+    const char* label;   // legend entry
+    Color_t color;
+};
+
+inline const std::vector<TrackSelection>& TrackSelections() {
+    static const std::vector<TrackSelection> selections = {
+        {"id9646", "loose", "Loose cuts", kPink+7},
+        {"id9647", "tight", "Tight cuts", kViolet+2},
+        {"id9648", "GlobalTracks", "GlobalTracks selection", kTeal-5}
+    };
+    return selections;
+}
+
+// Runs fn(input, selection) once per selection and returns the results in the order of the selections.
+// The selections read different directories of the same file and do not depend on each other, so with parallel = true
+// each one runs in a forked worker (ROOT::TProcessExecutor) that opens its own input. The binned cache of the file is
+// brought up to date once before forking, so the workers all read the same cache; if that fails they read the ROOT file
+// instead of each trying to build the cache again. Processes are used instead of
+// threads because the plotting code draws and saves canvases, and ROOT graphics is not thread safe.
+// fn must return an arithmetic type or a TObject-derived pointer; returned histograms must be detached from the file
+// (SetDirectory(nullptr)), they are sent back to the parent process and owned by the caller.
+template <class F>
+auto RunSelections(const char* fileName, const std::vector<TrackSelection>& selections, F fn, bool parallel = true)
+    -> std::vector<decltype(fn(std::declval<AnalysisInput*>(), std::declval<const TrackSelection&>()))> {
+    using Result = decltype(fn(std::declval<AnalysisInput*>(), std::declval<const TrackSelection&>()));
+    TString inputFile = fileName;
+    auto processSelection = [&](int i) -> Result {
+        AnalysisInput* input = AnalysisInput::Open(inputFile, false);
+        if (!input) {
+            std::cerr << "Error opening input " << inputFile << " for selection " << selections[i].name << "." << std::endl;
+            return Result{};
+        }
+        Result result = fn(input, selections[i]);
+        delete input;
+        return result;
+    };
+    AnalysisInput::PrepareCache(inputFile);
+
+    std::vector<Result> results;
+    if (!parallel || selections.size() < 2) {
+        for (size_t i = 0; i < selections.size(); ++i) {
+            results.push_back(processSelection(i));
+        }
+        return results;
+    }
+    SysInfo_t sysInfo;
+    gSystem->GetSysInfo(&sysInfo);
+    unsigned nWorkers = std::max(1, std::min<int>(selections.size(), sysInfo.fCpus));
+    // Workers draw and save canvases, and must not share the graphics connection of the parent
+    bool wasBatch = gROOT->IsBatch();
+    gROOT->SetBatch(kTRUE);
+    ROOT::TProcessExecutor workers(nWorkers);
+    results = workers.Map(processSelection, ROOT::TSeqI(selections.size()));
+    gROOT->SetBatch(wasBatch);
+    return results;
+}
+
+#endif
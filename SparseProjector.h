@@ -0,0 +1,169 @@
+#ifndef SPARSEPROJECTOR_H
+#define SPARSEPROJECTOR_H
+
+#include <TH1D.h>
+#include <TH2D.h>
+#include <THnSparse.h>
+#include <TAxis.h>
+#include <TString.h>
+#include <vector>
+#include <iostream>
+
+// One projection to be filled by ProjectSlices.
+// axis1/axis2 follow the THnSparse::Projection(axis1, axis2) convention used by Project2D:
+// axis1 ends up on the y axis and axis2 on the x axis. axis2 = -1 requests a 1D projection on axis1.
+// The pT window is applied as in Project2DRange (FindBin(ptMin) .. FindBin(ptMax) - 1 on the pT axis),
+// ptMax <= ptMin means no window at all (all pT bins, under/overflow included, as in Project1D/Project2D).
+struct SparseSlice {
+    int axis1;
+    int axis2;
+    double ptMin;
+    double ptMax;
+};
+
+// Output of ProjectSlices, one entry per requested slice in the same order.
+// hists2D[i] is filled for 2D slices and hists1D[i] for 1D slices, the other one is nullptr.
+// The histograms are detached from any directory and owned by the caller.
+struct SparseProjectionResult {
+    std::vector<TH2D*> hists2D;
+    std::vector<TH1D*> hists1D;
+};
+
+// Copies the binning of the sparse axis into a fresh axis of the output histogram.
+// If the axis is the pT axis and a window is set, only the bins [first, last] are kept, like THnSparse::Projection does for ranged axes.
+inline void CopySliceAxis(const TAxis* src, int first, int last, std::vector<double>& edges) {
+    edges.clear();
+    for (int b = first; b <= last; ++b) {
+        edges.push_back(src->GetBinLowEdge(b));
+    }
+    edges.push_back(src->GetBinUpEdge(last));
+}
+
+inline void CopySliceAxisLabels(const TAxis* src, TAxis* dst, int first) {
+    dst->SetTitle(src->GetTitle());
+    if (!src->GetLabels()) return;
+    for (int b = 1; b <= dst->GetNbins(); ++b) {
+        const char* label = src->GetBinLabel(b + first - 1);
+        if (label && label[0]) dst->SetBinLabel(b, label);
+    }
+}
+
+// Fills every requested (axis1, axis2, pT window) projection of the sparse histogram in a single pass over its filled bins.
+// Contents and squared errors are accumulated exactly as THnSparse::Projection(..., "E") does, so the result is equivalent
+// to calling Project2DRange / Project1D once per slice, but the cost no longer grows with the number of slices.
+inline SparseProjectionResult ProjectSlices(THnSparse* h, const std::vector<SparseSlice>& slices, int ptAxis = 0) {
+    SparseProjectionResult result;
+    result.hists2D.assign(slices.size(), nullptr);
+    result.hists1D.assign(slices.size(), nullptr);
+    if (!h) return result;
+
+    int nDims = h->GetNdimensions();
+    TAxis* ptAx = h->GetAxis(ptAxis);
+    int nPtCells = ptAx->GetNbins() + 2;
+
+    // Per slice: pT bin window, first bin kept on each output axis, and the linear bin stride of the output
+    std::vector<int> ptFirst(slices.size()), ptLast(slices.size());
+    std::vector<int> offsetX(slices.size(), 0), offsetY(slices.size(), 0), strideY(slices.size(), 0);
+    std::vector<TH1*> targets(slices.size(), nullptr);
+    std::vector<double> rawSum(slices.size(), 0.);
+    // For each pT bin (under/overflow included) the list of slices it contributes to
+    std::vector<std::vector<int>> slicesForPtBin(nPtCells);
+
+    bool addDirectory = TH1::AddDirectoryStatus();
+    TH1::AddDirectory(kFALSE);
+    std::vector<double> edgesX, edgesY;
+    for (size_t s = 0; s < slices.size(); ++s) {
+        const SparseSlice& slice = slices[s];
+        bool is2D = slice.axis2 >= 0;
+        if (slice.axis1 < 0 || slice.axis1 >= nDims || slice.axis2 >= nDims) {
+            std::cerr << "Invalid projection axes (" << slice.axis1 << ", " << slice.axis2 << ") for " << h->GetName() << "." << std::endl;
+            continue;
+        }
+        bool hasWindow = slice.ptMax > slice.ptMin;
+        ptFirst[s] = hasWindow ? ptAx->FindBin(slice.ptMin) : 0;
+        ptLast[s] = hasWindow ? ptAx->FindBin(slice.ptMax) - 1 : nPtCells - 1;
+        if (hasWindow && ptLast[s] < ptFirst[s]) {
+            std::cerr << "Empty pT range [" << slice.ptMin << ", " << slice.ptMax << "] for " << h->GetName() << "." << std::endl;
+            continue;
+        }
+        for (int b = ptFirst[s]; b <= ptLast[s]; ++b) {
+            slicesForPtBin[b].push_back(s);
+        }
+
+        TAxis* axY = h->GetAxis(slice.axis1);
+        int firstY = 1, lastY = axY->GetNbins();
+        if (hasWindow && slice.axis1 == ptAxis) {
+            firstY = ptFirst[s];
+            lastY = ptLast[s];
+        }
+        CopySliceAxis(axY, firstY, lastY, edgesY);
+        offsetY[s] = firstY - 1;
+        TString suffix = hasWindow ? TString::Format("_pt_%g_%g", slice.ptMin, slice.ptMax) : TString("");
+
+        if (is2D) {
+            TAxis* axX = h->GetAxis(slice.axis2);
+            int firstX = 1, lastX = axX->GetNbins();
+            if (hasWindow && slice.axis2 == ptAxis) {
+                firstX = ptFirst[s];
+                lastX = ptLast[s];
+            }
+            CopySliceAxis(axX, firstX, lastX, edgesX);
+            offsetX[s] = firstX - 1;
+            TH2D* h2 = new TH2D(TString::Format("%s_Proj2D_%d_%d%s", h->GetName(), slice.axis1, slice.axis2, suffix.Data()),
+                                TString::Format("%s projection %d vs %d", h->GetTitle(), slice.axis1, slice.axis2),
+                                edgesX.size() - 1, edgesX.data(), edgesY.size() - 1, edgesY.data());
+            CopySliceAxisLabels(axX, h2->GetXaxis(), firstX);
+            CopySliceAxisLabels(axY, h2->GetYaxis(), firstY);
+            strideY[s] = h2->GetNbinsX() + 2;
+            result.hists2D[s] = h2;
+            targets[s] = h2;
+        } else {
+            TH1D* h1 = new TH1D(TString::Format("%s_Proj1D_%d%s", h->GetName(), slice.axis1, suffix.Data()),
+                                TString::Format("%s projection %d", h->GetTitle(), slice.axis1),
+                                edgesY.size() - 1, edgesY.data());
+            CopySliceAxisLabels(axY, h1->GetXaxis(), firstY);
+            result.hists1D[s] = h1;
+            targets[s] = h1;
+        }
+        targets[s]->Sumw2();
+    }
+    TH1::AddDirectory(addDirectory);
+
+    // Raw pointers to the sumw2 arrays, so the inner loop adds the squared errors without a GetSumw2() lookup per bin
+    std::vector<double*> sumw2(slices.size(), nullptr);
+    for (size_t s = 0; s < slices.size(); ++s) {
+        if (targets[s]) sumw2[s] = targets[s]->GetSumw2()->GetArray();
+    }
+
+    std::vector<Int_t> coord(nDims);
+    Long64_t nFilled = h->GetNbins();
+    for (Long64_t idx = 0; idx < nFilled; ++idx) {
+        double content = h->GetBinContent(idx, coord.data());
+        const std::vector<int>& matching = slicesForPtBin[coord[ptAxis]];
+        if (matching.empty()) continue;
+        double error2 = h->GetBinError2(idx);
+        for (int s : matching) {
+            const SparseSlice& slice = slices[s];
+            int binY = coord[slice.axis1] - offsetY[s];
+            int bin = binY;
+            if (slice.axis2 >= 0) {
+                // TH2 global bin: binX + (nbinsX + 2) * binY
+                int binX = coord[slice.axis2] - offsetX[s];
+                bin = binX + strideY[s] * binY;
+            }
+            targets[s]->AddBinContent(bin, content);
+            sumw2[s][bin] += error2;
+            rawSum[s] += content;
+        }
+    }
+
+    for (size_t s = 0; s < slices.size(); ++s) {
+        if (!targets[s]) continue;
+        targets[s]->ResetStats();
+        // Without a pT window no bin is skipped, so the projection keeps the entries of the sparse histogram
+        targets[s]->SetEntries(slices[s].ptMax > slices[s].ptMin ? rawSum[s] : h->GetEntries());
+    }
+    return result;
+}
+
+#endif
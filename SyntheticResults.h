@@ -0,0 +1,202 @@
+#ifndef SYNTHETICRESULTS_H
+#define SYNTHETICRESULTS_H
+
+#include <Rtypes.h>
+#include <TFile.h>
+#include <TDirectory.h>
+#include <TH1F.h>
+#include <TH3F.h>
+#include <THnSparse.h>
+#include <TRandom3.h>
+#include <TMath.h>
+#include <TString.h>
+#include <TSystem.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include "SelectionRunner.h"
+
+// Size of a synthetic AnalysisResults.root: fill density and binning of every object
+struct SyntheticConfig {
+    Long64_t nEvents = 100000;      // fills of the EventProp histograms
+    Long64_t nTracks = 100000;      // fills of each track-jet-qa sparse
+    Long64_t nJets = 20000;         // fills of h_jet_pt, each jet adds a few emissions to the Lund planes
+    int ptBins = 200;               // track and jet pT axes, 0-200 GeV/c
+    int observableBins = 100;       // every other axis of the sparses
+    int lundBins = 50;              // x and y axes of the Lund planes
+    UInt_t seed = 42;
+};
+
+struct SyntheticAxis {
+    const char* name;
+    const char* title;
+    double min;
+    double max;
+};
+
+// One sparse of a track-jet-qa directory. Track histograms have pT on axis 0, then the centrality if withCentrality,
+// then their observables, in the axis order the plotting macros project.
+struct SyntheticSparse {
+    std::string path;
+    bool withPt;
+    bool withCentrality;
+    std::vector<SyntheticAxis> observables;
+};
+
+inline const std::vector<SyntheticSparse>& SyntheticSparses() {
+    static const std::vector<SyntheticSparse> sparses = [] {
+        std::vector<SyntheticSparse> list = {
+            {"EventProp/collisionVtxZ", false, false, {{"vtxZ", "Vtx_{z} [cm]", -20, 20}}},
+            {"EventProp/collisionVtxZnoSel", false, false, {{"vtxZ", "Vtx_{z} [cm]", -20, 20}}},
+            {"EventProp/collisionVtxZSel8", false, false, {{"vtxZ", "Vtx_{z} [cm]", -20, 20}}},
+            {"Kine/pt", true, true, {}},
+            {"Kine/pt_TRD", true, true, {}},
+            {"Kine/EtaPhiPt", true, true, {{"eta", "#eta", -1, 1}, {"phi", "#phi [rad]", 0, TMath::TwoPi()}}},
+            {"TrackPar/xyz", true, true, {{"x", "#it{x} [cm]", -0.5, 0.5}, {"y", "#it{y} [cm]", -0.5, 0.5}, {"z", "#it{z} [cm]", -10, 10}}},
+            {"TrackPar/alpha", true, true, {{"alpha", "#alpha [rad]", -TMath::Pi(), TMath::Pi()}}},
+            {"TrackPar/signed1Pt", true, true, {{"signed1Pt", "q/p_{T}", -8, 8}}},
+            {"TrackPar/snp", true, true, {{"snp", "snp", -1, 1}}},
+            {"TrackPar/tgl", true, true, {{"tgl", "tgl", -1.5, 1.5}}},
+            {"TrackPar/dcaXY", true, true, {{"dcaXY", "dcaXY [cm]", -0.5, 0.5}}},
+            {"TrackPar/dcaZ", true, true, {{"dcaZ", "dcaZ [cm]", -0.5, 0.5}}},
+            {"TrackPar/length", true, true, {{"length", "length [cm]", 0, 1000}}},
+            {"ITS/itsNCls", true, true, {{"itsNCls", "Number of ITS clusters", 0, 10}}},
+            {"ITS/itsChi2NCl", true, true, {{"itsChi2NCl", "#chi^{2} per ITS clusters", 0, 40}}},
+            {"ITS/itsHits", true, true, {{"itsHits", "ITS layers", 0, 7}}},
+            {"TPC/tpcNClsFindable", true, true, {{"tpcNClsFindable", "Number of findable TPC clusters", 0, 165}}},
+            {"TPC/tpcNClsFound", true, true, {{"tpcNClsFound", "Number of found TPC clusters", 0, 165}}},
+            {"TPC/tpcNClsShared", true, true, {{"tpcNClsShared", "Number of shared TPC clusters", 0, 165}}},
+            {"TPC/tpcNClsCrossedRows", true, true, {{"tpcNClsCrossedRows", "Number of crossed TPC rows", 0, 165}}},
+            {"TPC/tpcFractionSharedCls", true, true, {{"tpcFractionSharedCls", "Fraction of shared TPC clusters", 0, 1}}},
+            {"TPC/tpcCrossedRowsOverFindableCls", true, true, {{"tpcCrossedRowsOverFindableCls", "crossed TPC rows / findable clusters", 0, 2}}},
+            {"TPC/tpcChi2NCl", true, true, {{"tpcChi2NCl", "#chi^{2} per TPC clusters", 0, 10}}}
+        };
+        for (const char* sigma : {"Sigma1Pt", "Sigma1Pt_hasTRD", "Sigma1Pt_hasNoTRD", "Sigma1Pt_Layer1", "Sigma1Pt_Layer2", "Sigma1Pt_Layers12",
+                                  "Sigma1Pt_Layer4", "Sigma1Pt_Layer5", "Sigma1Pt_Layer6", "Sigma1Pt_Layers45", "Sigma1Pt_Layers46",
+                                  "Sigma1Pt_Layers56", "Sigma1Pt_Layers456"}) {
+            list.push_back({std::string("TrackPar/") + sigma, true, false, {{"sigma1Pt", "p_{T}#sigma(1/p_{T})", 0, 1}}});
+        }
+        return list;
+    }();
+    return sparses;
+}
+
+// Steeply falling spectrum with a power-law tail, so that every pT window of the macros gets entries
+inline double SyntheticPt(TRandom3& random, double ptMax) {
+    double pt = random.Rndm() < 0.95 ? 0.15 + random.Exp(1.5) : 5 * std::pow(random.Rndm(), -1 / 2.5);
+    return std::min(pt, 0.999 * ptMax);
+}
+
+// Gaussian around the middle of the axis, kept inside the axis
+inline double SyntheticValue(TRandom3& random, const SyntheticAxis& axis) {
+    double width = axis.max - axis.min;
+    double value = random.Gaus(axis.min + 0.5 * width, width / 6);
+    return std::max(axis.min, std::min(value, axis.max - 1e-6 * width));
+}
+
+inline THnSparseD* MakeSyntheticSparse(const SyntheticSparse& definition, const SyntheticConfig& config, Long64_t nFills, TRandom3& random) {
+    std::vector<SyntheticAxis> axes;
+    if (definition.withPt) axes.push_back({"pt", "p_{T} (GeV/c)", 0, 200});
+    if (definition.withCentrality) axes.push_back({"centrality", "centrality", 0, 100});
+    axes.insert(axes.end(), definition.observables.begin(), definition.observables.end());
+    int nDims = axes.size();
+    std::vector<int> bins(nDims);
+    std::vector<double> mins(nDims), maxs(nDims);
+    for (int i = 0; i < nDims; ++i) {
+        bool isPt = definition.withPt && i == 0;
+        bool isCentrality = definition.withCentrality && i == (definition.withPt ? 1 : 0);
+        bins[i] = isPt ? config.ptBins : isCentrality ? 10 : config.observableBins;
+        mins[i] = axes[i].min;
+        maxs[i] = axes[i].max;
+    }
+    TString name = definition.path.substr(definition.path.rfind('/') + 1).c_str();
+    THnSparseD* sparse = new THnSparseD(name, name, nDims, bins.data(), mins.data(), maxs.data());
+    sparse->Sumw2();
+    for (int i = 0; i < nDims; ++i) {
+        sparse->GetAxis(i)->SetName(axes[i].name);
+        sparse->GetAxis(i)->SetTitle(axes[i].title);
+    }
+    std::vector<double> x(nDims);
+    for (Long64_t fill = 0; fill < nFills; ++fill) {
+        for (int i = 0; i < nDims; ++i) {
+            bool isPt = definition.withPt && i == 0;
+            bool isCentrality = definition.withCentrality && i == (definition.withPt ? 1 : 0);
+            x[i] = isPt ? SyntheticPt(random, 200) : isCentrality ? 100 * random.Rndm() : SyntheticValue(random, axes[i]);
+        }
+        sparse->Fill(x.data());
+    }
+    return sparse;
+}
+
+inline TDirectory* SyntheticDirectory(TDirectory* top, const TString& name) {
+    TDirectory* dir = top->GetDirectory(name);
+    return dir ? dir : top->mkdir(name);
+}
+
+// Writes an AnalysisResults.root with the layout, histogram types and axes the plotting macros read: the track-jet-qa
+// sparses of the three selections, jet-finder-charged-qa/h_jet_pt and the jet-lund-reclustering Lund planes.
+// The selections get different yields (loose > GlobalTracks > tight) so that their comparisons are not trivial.
+inline bool WriteSyntheticResults(const char* fileName, const SyntheticConfig& config = SyntheticConfig()) {
+    gSystem->mkdir(gSystem->GetDirName(fileName), kTRUE);
+    TFile* file = TFile::Open(fileName, "RECREATE");
+    if (!file || file->IsZombie()) {
+        std::cerr << "Error creating file " << fileName << "." << std::endl;
+        delete file;
+        return false;
+    }
+    TRandom3 random(config.seed);
+    const double selectionYields[] = {1.2, 0.8, 1.0};
+    const std::vector<TrackSelection>& selections = TrackSelections();
+    for (size_t s = 0; s < selections.size(); ++s) {
+        TDirectory* top = file->mkdir(TString::Format("track-jet-qa_%s", selections[s].id));
+        double yield = selectionYields[s % 3];
+        for (const SyntheticSparse& definition : SyntheticSparses()) {
+            Long64_t nFills = definition.withPt ? Long64_t(yield * config.nTracks) : config.nEvents;
+            THnSparseD* sparse = MakeSyntheticSparse(definition, config, nFills, random);
+            TString subDir = definition.path.substr(0, definition.path.rfind('/')).c_str();
+            SyntheticDirectory(top, subDir)->WriteTObject(sparse, sparse->GetName());
+            delete sparse;
+        }
+        TH1F* rejected = new TH1F("rejectedCollId", "rejectedCollId", 100, 0, config.nEvents);
+        rejected->SetDirectory(nullptr);
+        for (Long64_t i = 0; i < config.nEvents / 20; ++i) {
+            rejected->Fill(random.Rndm() * config.nEvents);
+        }
+        SyntheticDirectory(top, "EventProp")->WriteTObject(rejected, rejected->GetName());
+        delete rejected;
+    }
+
+    TH1F* jetPt = new TH1F("h_jet_pt", "jet pT;#it{p}_{T,jet} (GeV/#it{c});entries", config.ptBins, 0, 200);
+    TH3F* lundKt = new TH3F("PrimaryLundPlane_kT", "Primary Lund plane;ln(R/#Delta);ln(k_{t}/GeV);#it{p}_{T,jet} (GeV/#it{c})",
+                            config.lundBins, 0, 5, config.lundBins, -3, 5, config.ptBins, 0, 200);
+    TH3F* lundZ = new TH3F("PrimaryLundPlane_z", "Primary Lund plane;ln(R/#Delta);ln(1/z);#it{p}_{T,jet} (GeV/#it{c})",
+                           config.lundBins, 0, 5, config.lundBins, 0, 8, config.ptBins, 0, 200);
+    for (TH1* histo : std::vector<TH1*>{jetPt, lundKt, lundZ}) {
+        histo->SetDirectory(nullptr);
+        histo->Sumw2();
+    }
+    for (Long64_t jet = 0; jet < config.nJets; ++jet) {
+        double pt = std::min(5 + random.Exp(20), 199.9);
+        jetPt->Fill(pt);
+        int nEmissions = random.Poisson(2 + std::log(pt));
+        for (int i = 0; i < nEmissions; ++i) {
+            double lnRDelta = 4.5 * random.Rndm();
+            lundKt->Fill(lnRDelta, random.Gaus(0, 1), pt);
+            lundZ->Fill(lnRDelta, random.Exp(1.5), pt);
+        }
+    }
+    file->mkdir("jet-finder-charged-qa")->WriteTObject(jetPt, jetPt->GetName());
+    TDirectory* lund = file->mkdir("jet-lund-reclustering");
+    lund->WriteTObject(lundKt, lundKt->GetName());
+    lund->WriteTObject(lundZ, lundZ->GetName());
+    delete jetPt;
+    delete lundKt;
+    delete lundZ;
+
+    file->Close();
+    delete file;
+    return true;
+}
+
+#endif